@@ -0,0 +1,363 @@
+// Benchmark harness for the ThreadPool and Logger variants in this directory.
+// CMake builds it once per variant: BENCH_VARIANT_FILE names the source to
+// include (its main() is renamed), and BENCH_POOL or BENCH_LOGGER picks
+// which class is measured.
+//
+//   bench_<variant> [--producers 1,2,4,...] [--ops N] [--json out.json]
+//                   [--baseline old.json] [--tolerance 0.10]
+//
+// With --baseline, results are matched by benchmark, producers and payload;
+// a throughput drop or p99 rise beyond the tolerance is reported and makes
+// the exit code 1.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <array>
+#include <map>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#define main variant_main
+#include BENCH_VARIANT_FILE
+#undef main
+
+// Counted by the replacement operator new in BenchmarkAllocations.cpp.
+extern std::atomic<uint64_t> allocationCount;
+
+namespace bench {
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct Usage {
+    int64_t cpuNs = 0;
+    int64_t contextSwitches = 0;
+    uint64_t allocations = 0;
+};
+
+// CPU time and context switches for the whole process, so pool and writer
+// threads are included. Windows has no getrusage; only allocations count there.
+Usage sampleUsage() {
+    Usage usage;
+#ifndef _WIN32
+    rusage ru{};
+    getrusage(RUSAGE_SELF, &ru);
+    usage.cpuNs = (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000000LL +
+        (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1000LL;
+    usage.contextSwitches = ru.ru_nvcsw + ru.ru_nivcsw;
+#endif
+    usage.allocations = allocationCount.load(std::memory_order_relaxed);
+    return usage;
+}
+
+struct Result {
+    std::string benchmark;
+    int producers = 0;
+    size_t payload = 0;
+    uint64_t ops = 0;
+    double opsPerSec = 0;
+    double p50Ns = 0;
+    double p99Ns = 0;
+    double p999Ns = 0;
+    double cpuNsPerOp = 0;
+    double contextSwitchesPerOp = 0;
+    double allocationsPerOp = 0;
+};
+
+// Runs body(producer) on 'producers' threads released together, and fills
+// in throughput, latency percentiles and resource use per operation.
+template<class Body, class Finish>
+Result measure(const std::string& name, int producers, size_t payload, uint64_t ops,
+               std::vector<int64_t>& latencies, Body body, Finish finish) {
+    std::atomic<int> ready{ 0 };
+    std::atomic<bool> go{ false };
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p]() {
+            ready++;
+            while (!go) std::this_thread::yield();
+            body(p);
+        });
+    }
+    while (ready < producers) std::this_thread::yield();
+
+    Usage before = sampleUsage();
+    int64_t start = nowNs();
+    go = true;
+    for (auto& t : threads) t.join();
+    finish();
+    int64_t elapsed = nowNs() - start;
+    Usage after = sampleUsage();
+
+    Result r;
+    r.benchmark = name;
+    r.producers = producers;
+    r.payload = payload;
+    r.ops = ops;
+    r.opsPerSec = ops * 1e9 / std::max<int64_t>(elapsed, 1);
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double q) {
+        return latencies.empty() ? 0.0 : double(latencies[static_cast<size_t>(q * (latencies.size() - 1))]);
+    };
+    r.p50Ns = percentile(0.50);
+    r.p99Ns = percentile(0.99);
+    r.p999Ns = percentile(0.999);
+    r.cpuNsPerOp = double(after.cpuNs - before.cpuNs) / ops;
+    r.contextSwitchesPerOp = double(after.contextSwitches - before.contextSwitches) / ops;
+    r.allocationsPerOp = double(after.allocations - before.allocations) / ops;
+    return r;
+}
+
+#ifdef BENCH_POOL
+
+template<size_t Size>
+struct Payload {
+    std::array<char, Size> bytes{};
+};
+
+template<>
+struct Payload<0> {};
+
+// Producers flood the pool; latency is enqueue to task start, so it is
+// mostly time spent waiting in the queue.
+template<size_t Size>
+Result poolFlood(ThreadPool& pool, int producers, uint64_t ops) {
+    uint64_t perProducer = std::max<uint64_t>(1, ops / producers);
+    std::vector<int64_t> latencies(perProducer * producers);
+    std::atomic<uint64_t> started{ 0 };
+    return measure("task_flood", producers, Size, perProducer * producers, latencies,
+        [&](int p) {
+            Payload<Size> payload;
+            for (uint64_t i = 0; i < perProducer; ++i) {
+                int64_t* slot = &latencies[p * perProducer + i];
+                int64_t submitted = nowNs();
+                pool.enqueue([slot, submitted, payload, &started]() {
+                    *slot = nowNs() - submitted;
+                    (void)payload;
+                    started.fetch_add(1, std::memory_order_release);
+                });
+            }
+        },
+        [&]() {
+            while (started.load(std::memory_order_acquire) < perProducer * producers) std::this_thread::yield();
+        });
+}
+
+// Each producer waits for its task to start before submitting the next one,
+// so latency is the wake-up path rather than queueing.
+template<size_t Size>
+Result poolPaced(ThreadPool& pool, int producers, uint64_t ops) {
+    uint64_t perProducer = std::max<uint64_t>(1, ops / producers);
+    std::vector<int64_t> latencies(perProducer * producers);
+    return measure("task_paced", producers, Size, perProducer * producers, latencies,
+        [&](int p) {
+            Payload<Size> payload;
+            std::atomic<bool> started{ false };
+            for (uint64_t i = 0; i < perProducer; ++i) {
+                int64_t* slot = &latencies[p * perProducer + i];
+                started.store(false, std::memory_order_relaxed);
+                int64_t submitted = nowNs();
+                pool.enqueue([slot, submitted, payload, &started]() {
+                    *slot = nowNs() - submitted;
+                    (void)payload;
+                    started.store(true, std::memory_order_release);
+                });
+                while (!started.load(std::memory_order_acquire)) std::this_thread::yield();
+            }
+        },
+        []() {});
+}
+
+std::vector<Result> run(const std::vector<int>& producerCounts, uint64_t ops) {
+    std::vector<Result> results;
+    size_t workers = std::max(2u, std::thread::hardware_concurrency());
+    for (int producers : producerCounts) {
+        ThreadPool pool(workers);
+        results.push_back(poolFlood<0>(pool, producers, ops));
+        results.push_back(poolFlood<64>(pool, producers, ops));
+        results.push_back(poolFlood<1024>(pool, producers, ops));
+        results.push_back(poolPaced<0>(pool, producers, ops / 10));
+        results.push_back(poolPaced<1024>(pool, producers, ops / 10));
+    }
+    return results;
+}
+
+#endif
+
+#ifdef BENCH_LOGGER
+
+#ifdef BENCH_LOGGER_INSTANCE
+struct LoggerUnderTest {
+    Logger logger{ "bench_log.txt" };
+    void log(const std::string& message) { logger.log(message); }
+};
+#else
+struct LoggerUnderTest {
+#ifdef BENCH_LOGGER_UNBOUNDED
+    // Logger.cpp drops messages once its queue is full, and a dropped call
+    // would count as a completed op; let the queue grow instead.
+    LoggerUnderTest() { Logger::getInstance().setMaxQueuedMessages(SIZE_MAX); }
+#endif
+    void log(const std::string& message) { Logger::getInstance().log(Logger::LogLevel::INFO, message); }
+};
+#endif
+
+// Latency and throughput as seen by the caller of log(); the writer thread
+// keeps draining in the background and its CPU time is included.
+Result logCalls(LoggerUnderTest& logger, int producers, size_t payload, uint64_t ops) {
+    uint64_t perProducer = std::max<uint64_t>(1, ops / producers);
+    std::vector<int64_t> latencies(perProducer * producers);
+    return measure("log_call", producers, payload, perProducer * producers, latencies,
+        [&](int p) {
+            std::string message(payload, 'x');
+            for (uint64_t i = 0; i < perProducer; ++i) {
+                int64_t start = nowNs();
+                logger.log(message);
+                latencies[p * perProducer + i] = nowNs() - start;
+            }
+        },
+        []() {});
+}
+
+std::vector<Result> run(const std::vector<int>& producerCounts, uint64_t ops) {
+    static LoggerUnderTest logger;
+    std::vector<Result> results;
+    for (int producers : producerCounts) {
+        for (size_t payload : { 16, 256, 4096 }) {
+            results.push_back(logCalls(logger, producers, payload, ops / 5));
+        }
+    }
+    return results;
+}
+
+#endif
+
+std::string toJson(const std::vector<Result>& results) {
+    std::ostringstream out;
+    out.precision(12);
+    out << "{\n  \"variant\": \"" << BENCH_VARIANT_NAME << "\",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        // One result per line keeps the baseline reader trivial.
+        out << "    {\"benchmark\": \"" << r.benchmark << "\", \"producers\": " << r.producers
+            << ", \"payload\": " << r.payload << ", \"ops\": " << r.ops
+            << ", \"ops_per_sec\": " << r.opsPerSec << ", \"p50_ns\": " << r.p50Ns
+            << ", \"p99_ns\": " << r.p99Ns << ", \"p999_ns\": " << r.p999Ns
+            << ", \"cpu_ns_per_op\": " << r.cpuNsPerOp
+            << ", \"ctx_switches_per_op\": " << r.contextSwitchesPerOp
+            << ", \"allocs_per_op\": " << r.allocationsPerOp << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+    return out.str();
+}
+
+double jsonNumber(const std::string& line, const std::string& key) {
+    size_t pos = line.find("\"" + key + "\":");
+    return pos == std::string::npos ? 0 : std::strtod(line.c_str() + pos + key.size() + 3, nullptr);
+}
+
+std::string jsonString(const std::string& line, const std::string& key) {
+    size_t pos = line.find("\"" + key + "\": \"");
+    if (pos == std::string::npos) return "";
+    pos += key.size() + 5;
+    return line.substr(pos, line.find('"', pos) - pos);
+}
+
+std::string resultKey(const std::string& benchmark, int producers, size_t payload) {
+    return benchmark + "/p" + std::to_string(producers) + "/" + std::to_string(payload) + "B";
+}
+
+// Returns the number of regressions against the baseline file.
+int compareBaseline(const std::vector<Result>& results, const std::string& path, double tolerance) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        std::cerr << "Cannot open baseline " << path << std::endl;
+        return 1;
+    }
+    std::map<std::string, std::pair<double, double>> baseline;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::string benchmark = jsonString(line, "benchmark");
+        if (benchmark.empty()) continue;
+        std::string key = resultKey(benchmark, static_cast<int>(jsonNumber(line, "producers")),
+            static_cast<size_t>(jsonNumber(line, "payload")));
+        baseline[key] = { jsonNumber(line, "ops_per_sec"), jsonNumber(line, "p99_ns") };
+    }
+
+    int regressions = 0;
+    std::printf("\n%-28s %14s %14s %10s %10s\n", "vs baseline", "ops/s", "base ops/s", "ops/s", "p99");
+    for (const Result& r : results) {
+        std::string key = resultKey(r.benchmark, r.producers, r.payload);
+        auto it = baseline.find(key);
+        if (it == baseline.end()) continue;
+        double throughputChange = it->second.first > 0 ? r.opsPerSec / it->second.first - 1 : 0;
+        double p99Change = it->second.second > 0 ? r.p99Ns / it->second.second - 1 : 0;
+        bool regressed = throughputChange < -tolerance || p99Change > tolerance;
+        regressions += regressed;
+        std::printf("%-28s %14.0f %14.0f %+9.1f%% %+9.1f%%%s\n", key.c_str(), r.opsPerSec, it->second.first,
+            throughputChange * 100, p99Change * 100, regressed ? "  REGRESSION" : "");
+    }
+    return regressions;
+}
+
+} // namespace bench
+
+int main(int argc, char* argv[]) {
+    std::vector<int> producerCounts = { 1, 2, 4, 8, 16, 32, 64 };
+    uint64_t ops = 100000;
+    std::string jsonPath;
+    std::string baselinePath;
+    double tolerance = 0.10;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        std::string value = argv[i + 1];
+        if (arg == "--producers") {
+            producerCounts.clear();
+            std::stringstream list(value);
+            std::string item;
+            while (std::getline(list, item, ',')) producerCounts.push_back(std::max(1, std::stoi(item)));
+        }
+        else if (arg == "--ops") ops = std::stoull(value);
+        else if (arg == "--json") jsonPath = value;
+        else if (arg == "--baseline") baselinePath = value;
+        else if (arg == "--tolerance") tolerance = std::stod(value);
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 2;
+        }
+    }
+
+    std::vector<bench::Result> results = bench::run(producerCounts, ops);
+
+    std::printf("%s\n%-12s %9s %8s %10s %14s %10s %10s %10s %10s %8s %8s\n", BENCH_VARIANT_NAME, "benchmark",
+        "producers", "payload", "ops", "ops/s", "p50(ns)", "p99(ns)", "p999(ns)", "cpu/op", "csw/op", "alloc/op");
+    for (const bench::Result& r : results) {
+        std::printf("%-12s %9d %8zu %10llu %14.0f %10.0f %10.0f %10.0f %10.0f %8.3f %8.2f\n", r.benchmark.c_str(),
+            r.producers, r.payload, static_cast<unsigned long long>(r.ops), r.opsPerSec, r.p50Ns, r.p99Ns,
+            r.p999Ns, r.cpuNsPerOp, r.contextSwitchesPerOp, r.allocationsPerOp);
+    }
+
+    if (!jsonPath.empty()) {
+        std::ofstream out(jsonPath);
+        out << bench::toJson(results);
+    }
+    if (!baselinePath.empty()) {
+        return bench::compareBaseline(results, baselinePath, tolerance) ? 1 : 0;
+    }
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include "logcodec.h"
+
+// Reads compressed log segments written by Logger. Only blocks whose time
+// range overlaps [from, to] are read, and those are decompressed in parallel.
+//
+//   LogReader [--from "YYYY-MM-DD hh:mm:ss"] [--to "..."] [--threads N] segment.lgz...
+
+// Packs a user supplied time the way LogCodec does; missing trailing fields
+// are filled with 'fill' so "--to 2024-05-01" covers that whole day.
+uint64_t parseBound(const std::string& text, char fill) {
+    std::string digits;
+    for (char c : text) {
+        if (c >= '0' && c <= '9') digits.push_back(c);
+    }
+    digits.resize(14, fill);
+    return std::stoull(digits);
+}
+
+bool readSegment(const std::string& path, uint64_t from, uint64_t to, size_t threads) {
+    std::ifstream in(path, std::ios::binary);
+    LogFileHeader header;
+    std::vector<LogBlockIndex> index;
+    if (!in.is_open() || !LogCodec::readIndex(in, header, index)) {
+        std::cerr << path << ": not a compressed log segment\n";
+        return false;
+    }
+
+    std::vector<LogBlockIndex> selected;
+    for (const LogBlockIndex& block : index) {
+        // Blocks without any timestamp cannot be ruled out.
+        if (!block.minTime || (block.maxTime >= from && block.minTime <= to)) {
+            selected.push_back(block);
+        }
+    }
+    if (selected.empty()) return true;
+
+    // Selected blocks are usually contiguous, so read their span in one go.
+    uint64_t spanBegin = selected.front().offset;
+    uint64_t spanEnd = selected.back().offset + selected.back().compressedSize;
+    std::string compressed(static_cast<size_t>(spanEnd - spanBegin), '\0');
+    in.clear();
+    in.seekg(static_cast<std::streamoff>(spanBegin));
+    if (!in.read(&compressed[0], compressed.size())) {
+        std::cerr << path << ": truncated segment\n";
+        return false;
+    }
+
+    std::vector<std::string> blocks(selected.size());
+    std::atomic<size_t> next(0);
+    std::atomic<bool> corrupt(false);
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < std::min(threads, selected.size()); t++) {
+        workers.emplace_back([&]() {
+            for (size_t i = next++; i < selected.size(); i = next++) {
+                const LogBlockIndex& block = selected[i];
+                if (!LogCodec::decompressBlock(compressed.data() + (block.offset - spanBegin), block.compressedSize,
+                    block.rawSize, blocks[i])) {
+                    corrupt = true;
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    if (corrupt) {
+        std::cerr << path << ": corrupt block\n";
+        return false;
+    }
+
+    // Boundary blocks also hold lines outside the range; lines without a
+    // timestamp (continuations) follow the line before them.
+    bool keep = false;
+    for (size_t i = 0; i < blocks.size(); i++) {
+        const std::string& text = blocks[i];
+        if (selected[i].minTime >= from && selected[i].maxTime <= to && selected[i].minTime) {
+            std::cout << text;
+            keep = true;
+            continue;
+        }
+        size_t line = 0;
+        while (line < text.size()) {
+            size_t end = text.find('\n', line);
+            end = end == std::string::npos ? text.size() : end + 1;
+            uint64_t time = LogCodec::parseTimestamp(text.data() + line, end - line);
+            if (time) keep = time >= from && time <= to;
+            if (keep) std::cout.write(text.data() + line, end - line);
+            line = end;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t from = 0;
+    uint64_t to = UINT64_MAX;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "--from" || arg == "--to" || arg == "--threads") && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (arg == "--from") from = parseBound(value, '0');
+            else if (arg == "--to") to = parseBound(value, '9');
+            else threads = std::max<size_t>(1, std::stoul(value));
+        }
+        else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.empty()) {
+        std::cerr << "usage: LogReader [--from \"YYYY-MM-DD hh:mm:ss\"] [--to \"...\"] [--threads N] segment.lgz...\n";
+        return 1;
+    }
+
+    bool ok = true;
+    for (const std::string& path : paths) {
+        ok = readSegment(path, from, to, threads) && ok;
+    }
+    return ok ? 0 : 1;
+}
@@ -8,6 +8,17 @@
 #include <memory>
 #include <sstream>
 #include <chrono>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include "logcodec.h"
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+class LogSite;
 
 class Logger {
 public:
@@ -19,12 +30,15 @@ public:
     }
 
     void log(LogLevel level, const std::string& message) {
-        std::ostringstream logEntry;
-        logEntry << "[" << getTimestamp() << "] " << logLevelToString(level) << ": " << message << "\n";
-
+        std::string entry = formatEntry(level, message);
         {
             std::lock_guard<std::mutex> lock(mutex_);
-            logQueue_.push(logEntry.str());
+            if (logQueue_.size() >= maxQueued_) {
+                // Never block the caller; the drop count goes into the next summary.
+                droppedMessages_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            logQueue_.push(std::move(entry));
         }
         condVar_.notify_one();  // Wake up logging thread
     }
@@ -35,6 +49,35 @@ public:
         if (logThread_.joinable()) {
             logThread_.join();
         }
+        {
+            std::lock_guard<std::mutex> lock(compressMutex_);
+            isCompressing_ = false;
+        }
+        compressCondVar_.notify_one();
+        if (compressThread_.joinable()) {
+            compressThread_.join();
+        }
+    }
+
+    // log.txt is rotated once it grows past this many bytes.
+    void setMaxSegmentBytes(size_t bytes) {
+        maxSegmentBytes_ = bytes;
+    }
+
+    // Messages beyond this many waiting for the writer are dropped.
+    void setMaxQueuedMessages(size_t count) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        maxQueued_ = count;
+    }
+
+    void registerSite(LogSite* site) {
+        std::lock_guard<std::mutex> lock(sitesMutex_);
+        sites_.push_back(site);
+    }
+
+    void unregisterSite(LogSite* site) {
+        std::lock_guard<std::mutex> lock(sitesMutex_);
+        sites_.erase(std::remove(sites_.begin(), sites_.end(), site), sites_.end());
     }
 
 private:
@@ -44,8 +87,30 @@ private:
     std::atomic<bool> isRunning_;
     std::thread logThread_;
     std::ofstream logFile_;
+    size_t maxQueued_;
+    std::atomic<uint64_t> droppedMessages_;
 
-    Logger() : isRunning_(true), logFile_("log.txt", std::ios::app) {
+    // Rate limited call sites, polled for suppressed counts once per SummaryInterval.
+    static constexpr std::chrono::seconds SummaryInterval{ 1 };
+    std::vector<LogSite*> sites_;
+    std::mutex sitesMutex_;
+
+    // Rotated segments waiting for the compression thread.
+    std::queue<std::string> compressQueue_;
+    std::mutex compressMutex_;
+    std::condition_variable compressCondVar_;
+    bool isCompressing_;
+    std::thread compressThread_;
+    std::atomic<size_t> maxSegmentBytes_;
+    size_t segmentBytes_;
+    unsigned segmentCount_;
+
+    Logger() : isRunning_(true), logFile_("log.txt", std::ios::app), maxQueued_(64 * 1024), droppedMessages_(0),
+        isCompressing_(true),
+        maxSegmentBytes_(16 * 1024 * 1024), segmentBytes_(0), segmentCount_(0) {
+        logFile_.seekp(0, std::ios::end);
+        segmentBytes_ = static_cast<size_t>(logFile_.tellp());
+        compressThread_ = std::thread(&Logger::compressSegments, this);
         logThread_ = std::thread(&Logger::processLogs, this);
     }
 
@@ -54,26 +119,91 @@ private:
     }
 
     void processLogs() {
-        while (isRunning_ || !logQueue_.empty()) {
-            std::unique_lock<std::mutex> lock(mutex_);
-            condVar_.wait(lock, [this]() { return !logQueue_.empty() || !isRunning_; });
+        std::queue<std::string> batch;
+        auto nextSummary = std::chrono::steady_clock::now() + SummaryInterval;
+        bool running = true;
+        while (running) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                condVar_.wait_until(lock, nextSummary, [this]() { return !logQueue_.empty() || !isRunning_; });
+                // Take the whole queue so callers are not held up by file I/O.
+                std::swap(batch, logQueue_);
+                running = isRunning_;
+            }
 
-            while (!logQueue_.empty()) {
-                logFile_ << logQueue_.front();
-                logQueue_.pop();
+            while (!batch.empty()) {
+                write(batch.front());
+                batch.pop();
+            }
+            if (!running || std::chrono::steady_clock::now() >= nextSummary) {
+                writeSummaries();
+                nextSummary = std::chrono::steady_clock::now() + SummaryInterval;
             }
             logFile_.flush();
+            if (segmentBytes_ >= maxSegmentBytes_) {
+                rotate();
+            }
         }
     }
 
-    std::string getTimestamp() {
+    void write(const std::string& entry) {
+        logFile_ << entry;
+        segmentBytes_ += entry.size();
+    }
+
+    void writeSummaries();
+
+    // Renames the full log.txt to its own segment and hands it to the
+    // compression thread; only the rename and reopen happen on this thread.
+    void rotate() {
+        logFile_.close();
+        std::string segment = "log." + getTimestamp("%Y%m%d-%H%M%S") + "." + std::to_string(segmentCount_++) + ".txt";
+        bool renamed = std::rename("log.txt", segment.c_str()) == 0;
+        logFile_.open("log.txt", std::ios::app);
+        if (!renamed) return;
+        segmentBytes_ = 0;
+        {
+            std::lock_guard<std::mutex> lock(compressMutex_);
+            compressQueue_.push(segment);
+        }
+        compressCondVar_.notify_one();
+    }
+
+    void compressSegments() {
+#ifdef __linux__
+        // Nice only this thread so compression yields to the application.
+        setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19);
+#endif
+        while (true) {
+            std::string segment;
+            {
+                std::unique_lock<std::mutex> lock(compressMutex_);
+                compressCondVar_.wait(lock, [this]() { return !compressQueue_.empty() || !isCompressing_; });
+                if (compressQueue_.empty()) return;
+                segment = compressQueue_.front();
+                compressQueue_.pop();
+            }
+            std::string compressed = segment.substr(0, segment.size() - 4) + ".lgz";
+            if (LogCodec::compressFile(segment, compressed)) {
+                std::remove(segment.c_str());
+            }
+        }
+    }
+
+    std::string formatEntry(LogLevel level, const std::string& message) {
+        std::ostringstream logEntry;
+        logEntry << "[" << getTimestamp() << "] " << logLevelToString(level) << ": " << message << "\n";
+        return logEntry.str();
+    }
+
+    std::string getTimestamp(const char* format = "%Y-%m-%d %H:%M:%S") {
         auto now = std::chrono::system_clock::now();
         auto timeT = std::chrono::system_clock::to_time_t(now);
         std::tm tmStruct;
         localtime_r(&timeT, &tmStruct); // Thread-safe version of localtime
 
         char buffer[20];
-        strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &tmStruct);
+        strftime(buffer, sizeof(buffer), format, &tmStruct);
         return std::string(buffer);
     }
 
@@ -90,9 +220,93 @@ private:
     Logger& operator=(const Logger&) = delete;
 };
 
+// Per call site limiter behind the LOG_* macros. A token bucket refilled at
+// perSecond (0 = no limit) with room for burst messages, stored as the time
+// the bucket will be full again so admit() is a single CAS. sampleEvery = N
+// lets one call in N through before the bucket is even checked.
+class LogSite {
+public:
+    LogSite(const char* file, int line, double perSecond, double burst, uint32_t sampleEvery)
+        : file_(file), line_(line), sampleEvery_(sampleEvery ? sampleEvery : 1),
+        intervalNs_(perSecond > 0 ? static_cast<int64_t>(1e9 / perSecond) : 0),
+        toleranceNs_(perSecond > 0 ? static_cast<int64_t>((burst > 1 ? burst - 1 : 0) * 1e9 / perSecond) : 0) {
+        Logger::getInstance().registerSite(this);
+    }
+
+    ~LogSite() {
+        Logger::getInstance().unregisterSite(this);
+    }
+
+    bool admit() {
+        if (sampleEvery_ > 1 && calls_.fetch_add(1, std::memory_order_relaxed) % sampleEvery_ != 0) {
+            suppressed_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (intervalNs_) {
+            int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+            int64_t full = fullAt_.load(std::memory_order_relaxed);
+            do {
+                if (full - now > toleranceNs_) {
+                    suppressed_.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+            } while (!fullAt_.compare_exchange_weak(full, std::max(full, now) + intervalNs_, std::memory_order_relaxed));
+        }
+        return true;
+    }
+
+    uint64_t takeSuppressed() {
+        return suppressed_.exchange(0, std::memory_order_relaxed);
+    }
+
+    std::string where() const {
+        return std::string(file_) + ":" + std::to_string(line_);
+    }
+
+private:
+    const char* file_;
+    int line_;
+    uint32_t sampleEvery_;
+    int64_t intervalNs_;
+    int64_t toleranceNs_;
+    std::atomic<uint64_t> calls_{ 0 };
+    std::atomic<int64_t> fullAt_{ 0 };
+    std::atomic<uint64_t> suppressed_{ 0 };
+};
+
+// Writes one "suppressed" line per site that dropped messages since the last
+// summary, plus one for messages dropped because the queue was full.
+inline void Logger::writeSummaries() {
+    {
+        std::lock_guard<std::mutex> lock(sitesMutex_);
+        for (LogSite* site : sites_) {
+            uint64_t suppressed = site->takeSuppressed();
+            if (suppressed) {
+                write(formatEntry(LogLevel::WARN, "suppressed " + std::to_string(suppressed) + " messages from " + site->where()));
+            }
+        }
+    }
+    uint64_t dropped = droppedMessages_.exchange(0, std::memory_order_relaxed);
+    if (dropped) {
+        write(formatEntry(LogLevel::WARN, "dropped " + std::to_string(dropped) + " messages, log queue full"));
+    }
+}
+
+// The limits are read on the first call only. The message expression is not
+// evaluated when the call is suppressed.
+#define LOG_LIMITED(level, perSecond, burst, sampleEvery, message)                                  \
+    do {                                                                                            \
+        static LogSite logSite_(__FILE__, __LINE__, perSecond, burst, sampleEvery);                  \
+        if (logSite_.admit()) Logger::getInstance().log(level, message);                             \
+    } while (0)
+
+#define LOG_RATE_LIMITED(level, perSecond, burst, message) LOG_LIMITED(level, perSecond, burst, 1, message)
+#define LOG_SAMPLED(level, sampleEvery, message) LOG_LIMITED(level, 0, 0, sampleEvery, message)
+
 void workerThread(int id) {
     for (int i = 0; i < 5; ++i) {
-        Logger::getInstance().log(Logger::LogLevel::INFO, "Thread " + std::to_string(id) + " logging message " + std::to_string(i));
+        LOG_RATE_LIMITED(Logger::LogLevel::INFO, 100, 20, "Thread " + std::to_string(id) + " logging message " + std::to_string(i));
         std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
 }
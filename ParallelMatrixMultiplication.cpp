@@ -1,17 +1,28 @@
 #include <iostream>
 #include <vector>
 #include <thread>
+#include <stdexcept>
+#include <utility>
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 
-void multiplyRow(const std::vector<std::vector<int>>& A,
-                 const std::vector<std::vector<int>>& B,
-                 std::vector<std::vector<int>>& C,
-                 int row) {
+// Below this many multiply-adds, starting threads costs more than it saves.
+const size_t ParallelThreshold = 1 << 16;
+
+void multiplyRows(const std::vector<std::vector<int>>& A,
+                  const std::vector<std::vector<int>>& B,
+                  std::vector<std::vector<int>>& C,
+                  int firstRow, int endRow) {
     int colsB = B[0].size();
     int colsA = A[0].size();
-    for (int col = 0; col < colsB; ++col) {
-        C[row][col] = 0;
-        for (int k = 0; k < colsA; ++k) {
-            C[row][col] += A[row][k] * B[k][col];
+    for (int row = firstRow; row < endRow; ++row) {
+        for (int col = 0; col < colsB; ++col) {
+            C[row][col] = 0;
+            for (int k = 0; k < colsA; ++k) {
+                C[row][col] += A[row][k] * B[k][col];
+            }
         }
     }
 }
@@ -28,9 +39,17 @@ std::vector<std::vector<int>> parallelMatrixMultiply(const std::vector<std::vect
 
     std::vector<std::vector<int>> C(rowsA, std::vector<int>(colsB, 0));
 
-     std::vector<std::thread> threads;
-    for (int i = 0; i < rowsA; ++i) {
-        threads.emplace_back(multiplyRow, std::cref(A), std::cref(B), std::ref(C), i);
+    if (static_cast<size_t>(rowsA) * colsA * colsB < ParallelThreshold) {
+        multiplyRows(A, B, C, 0, rowsA);
+        return C;
+    }
+
+    // One contiguous band of rows per hardware thread.
+    int numThreads = std::min<int>(rowsA, std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; ++t) {
+        threads.emplace_back(multiplyRows, std::cref(A), std::cref(B), std::ref(C),
+                             rowsA * t / numThreads, rowsA * (t + 1) / numThreads);
     }
 
     for (auto& th : threads) {
@@ -40,6 +59,135 @@ std::vector<std::vector<int>> parallelMatrixMultiply(const std::vector<std::vect
     return C;
 }
 
+// Small matrix with its shape in the type. operator* expands to one
+// expression per output element, so the whole product is unrolled at
+// compile time and can be evaluated in a constant expression.
+template<class T, size_t R, size_t C>
+struct FixedMatrix {
+    T m[R][C];
+
+    constexpr T& operator()(size_t row, size_t col) { return m[row][col]; }
+    constexpr const T& operator()(size_t row, size_t col) const { return m[row][col]; }
+};
+
+template<class T, size_t R, size_t K, size_t C, size_t... Ks>
+constexpr T fixedDot(const FixedMatrix<T, R, K>& a, const FixedMatrix<T, K, C>& b,
+                     size_t row, size_t col, std::index_sequence<Ks...>) {
+    return ((a.m[row][Ks] * b.m[Ks][col]) + ...);
+}
+
+template<class T, size_t R, size_t K, size_t C, size_t... Is>
+constexpr FixedMatrix<T, R, C> fixedMultiply(const FixedMatrix<T, R, K>& a, const FixedMatrix<T, K, C>& b,
+                                             std::index_sequence<Is...>) {
+    return FixedMatrix<T, R, C>{ { fixedDot(a, b, Is / C, Is % C, std::make_index_sequence<K>{})... } };
+}
+
+template<class T, size_t R, size_t K, size_t C>
+constexpr FixedMatrix<T, R, C> operator*(const FixedMatrix<T, R, K>& a, const FixedMatrix<T, K, C>& b) {
+    return fixedMultiply(a, b, std::make_index_sequence<R * C>{});
+}
+
+// Many R x C matrices stored structure-of-arrays: element (row, col) of every
+// matrix in the batch is one contiguous array, so batched math runs down
+// those arrays and the compiler can vectorize across the batch. Each array
+// starts on a cache line of its own.
+template<class T, size_t R, size_t C>
+class MatrixBatch {
+public:
+    static constexpr size_t CacheLine = 64;
+    static constexpr size_t LineElements = CacheLine / sizeof(T) ? CacheLine / sizeof(T) : 1;
+
+    explicit MatrixBatch(size_t count)
+        : count_(count), stride_((count + LineElements - 1) / LineElements * LineElements),
+          data_(R * C * stride_ + LineElements) {}
+
+    size_t size() const { return count_; }
+    T* element(size_t row, size_t col) { return base() + (row * C + col) * stride_; }
+    const T* element(size_t row, size_t col) const { return base() + (row * C + col) * stride_; }
+
+    FixedMatrix<T, R, C> get(size_t i) const {
+        FixedMatrix<T, R, C> out{};
+        for (size_t row = 0; row < R; ++row)
+            for (size_t col = 0; col < C; ++col)
+                out.m[row][col] = element(row, col)[i];
+        return out;
+    }
+
+    void set(size_t i, const FixedMatrix<T, R, C>& value) {
+        for (size_t row = 0; row < R; ++row)
+            for (size_t col = 0; col < C; ++col)
+                element(row, col)[i] = value.m[row][col];
+    }
+
+private:
+    size_t count_;
+    size_t stride_;    // count_ rounded up to whole cache lines
+    std::vector<T> data_;
+
+    // First cache-line boundary inside data_ (recomputed, so copies stay valid).
+    const T* base() const {
+        size_t misalign = reinterpret_cast<uintptr_t>(data_.data()) % CacheLine / sizeof(T);
+        return data_.data() + (misalign ? LineElements - misalign : 0);
+    }
+    T* base() { return const_cast<T*>(static_cast<const MatrixBatch*>(this)->base()); }
+};
+
+// out[i] = A[i] * B[i] for i in [first, last). R, K and C are compile-time,
+// so only the innermost loop over the batch remains, and it is a plain
+// streaming multiply-add that the compiler turns into SIMD.
+template<class T, size_t R, size_t K, size_t C>
+void batchMultiplyRange(const MatrixBatch<T, R, K>& A, const MatrixBatch<T, K, C>& B,
+                        MatrixBatch<T, R, C>& out, size_t first, size_t last) {
+    for (size_t row = 0; row < R; ++row) {
+        for (size_t col = 0; col < C; ++col) {
+            T* __restrict o = out.element(row, col);
+            const T* __restrict a = A.element(row, 0);
+            const T* __restrict b = B.element(0, col);
+            for (size_t i = first; i < last; ++i) {
+                o[i] = a[i] * b[i];
+            }
+            for (size_t k = 1; k < K; ++k) {
+                a = A.element(row, k);
+                b = B.element(k, col);
+                for (size_t i = first; i < last; ++i) {
+                    o[i] += a[i] * b[i];
+                }
+            }
+        }
+    }
+}
+
+template<class T, size_t R, size_t K, size_t C>
+void batchMultiply(const MatrixBatch<T, R, K>& A, const MatrixBatch<T, K, C>& B, MatrixBatch<T, R, C>& out) {
+    size_t count = A.size();
+    if (B.size() != count || out.size() != count) {
+        throw std::invalid_argument("Matrix batches differ in size");
+    }
+    // out is written while A and B are still being read.
+    if (static_cast<const void*>(&out) == static_cast<const void*>(&A) ||
+        static_cast<const void*>(&out) == static_cast<const void*>(&B)) {
+        throw std::invalid_argument("Output batch must not alias an input");
+    }
+    if (count * R * K * C < ParallelThreshold) {
+        batchMultiplyRange(A, B, out, 0, count);
+        return;
+    }
+
+    // Arrays start on cache lines and chunks are multiples of 64 elements, so
+    // threads never share a cache line of out.
+    size_t numThreads = std::max(1u, std::thread::hardware_concurrency());
+    size_t chunk = ((count + numThreads - 1) / numThreads + 63) / 64 * 64;
+    std::vector<std::thread> threads;
+    for (size_t first = 0; first < count; first += chunk) {
+        size_t last = std::min(count, first + chunk);
+        threads.emplace_back([&A, &B, &out, first, last]() { batchMultiplyRange(A, B, out, first, last); });
+    }
+
+    for (auto& th : threads) {
+        th.join();
+    }
+}
+
 void printMatrix(const std::vector<std::vector<int>>& matrix) {
     for (const auto& row : matrix) {
         for (int val : row) {
@@ -70,5 +218,37 @@ int main() {
         std::cerr << "Error: " << e.what() << std::endl;
     }
 
+    constexpr FixedMatrix<int, 3, 3> FA = { { {1, 2, 3}, {4, 5, 6}, {7, 8, 9} } };
+    constexpr FixedMatrix<int, 3, 3> FB = { { {9, 8, 7}, {6, 5, 4}, {3, 2, 1} } };
+    constexpr FixedMatrix<int, 3, 3> FC = FA * FB;
+    static_assert(FC(0, 0) == 30 && FC(2, 2) == 90, "FixedMatrix product is computed at compile time");
+
+    // A batch of 4x4 transforms applied to 4x1 points.
+    const size_t batchSize = 1 << 20;
+    MatrixBatch<float, 4, 4> transforms(batchSize);
+    MatrixBatch<float, 4, 1> points(batchSize);
+    MatrixBatch<float, 4, 1> moved(batchSize);
+    for (size_t i = 0; i < batchSize; ++i) {
+        FixedMatrix<float, 4, 4> t = { { {1, 0, 0, float(i % 7)}, {0, 1, 0, 2}, {0, 0, 1, 3}, {0, 0, 0, 1} } };
+        FixedMatrix<float, 4, 1> p = { { {1}, {float(i % 5)}, {0}, {1} } };
+        transforms.set(i, t);
+        points.set(i, p);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    batchMultiply(transforms, points, moved);
+    auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < batchSize; i += 997) {
+        FixedMatrix<float, 4, 1> expected = transforms.get(i) * points.get(i);
+        FixedMatrix<float, 4, 1> actual = moved.get(i);
+        for (size_t row = 0; row < 4; ++row) {
+            if (expected(row, 0) != actual(row, 0)) ++mismatches;
+        }
+    }
+    std::cout << "Batched " << batchSize << " 4x4 transforms in " << elapsed << " ms, "
+              << mismatches << " mismatches" << std::endl;
+
     return 0;
 }
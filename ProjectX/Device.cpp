@@ -1,41 +1,69 @@
-#include "device.h"
-
-void Light::turnOn() {
-	status = true;
-}
-void Light::turnOff() {
-	status = false;
-}
-string Light::getStatus() {
-	if (status) {
-		return "Light is On";
-	}
-	return "Light is Off";
-}
-
-void Fan::turnOn() {
-	status = true;
-}
-void Fan::turnOff() {
-	status = false;
-}
-string Fan::getStatus() {
-	if (status) {
-		return "Light is On";
-	}
-	return "Light is Off";
-}
-
-void AirConditioner::turnOn() {
-	status = true;
-}
-void AirConditioner::turnOff() {
-	status = false;
-}
-string AirConditioner::getStatus() {
-	if (status) {
-		return "Light is On";
-	}
-	return "Light is Off";
-}
-
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "device.h"
+
+static std::atomic<uint64_t> sequence{ 0 };
+
+// seq_cst on both sides: a writer's Changing mark is ordered before the
+// sequence it takes, and so before any export that sees that sequence.
+uint64_t Device::nextSequence() {
+	return sequence.fetch_add(1, std::memory_order_seq_cst) + 1;
+}
+uint64_t Device::currentSequence() {
+	return sequence.load(std::memory_order_seq_cst);
+}
+uint64_t Device::sequenceEpoch() {
+	static const uint64_t epoch = static_cast<uint64_t>(
+		std::chrono::system_clock::now().time_since_epoch().count());
+	return epoch;
+}
+
+uint64_t Device::lastChange() const {
+	uint64_t value = changed.load(std::memory_order_seq_cst);
+	while (value == Changing) {
+		// The writer is a few instructions from done unless it was preempted.
+		std::this_thread::yield();
+		value = changed.load(std::memory_order_seq_cst);
+	}
+	return value;
+}
+
+void Light::turnOn() {
+	setState(status, true);
+}
+void Light::turnOff() {
+	setState(status, false);
+}
+std::string_view Light::statusText() const {
+	if (status) {
+		return "Light is On";
+	}
+	return "Light is Off";
+}
+
+void Fan::turnOn() {
+	setState(status, true);
+}
+void Fan::turnOff() {
+	setState(status, false);
+}
+std::string_view Fan::statusText() const {
+	if (status) {
+		return "Fan is On";
+	}
+	return "Fan is Off";
+}
+
+void AirConditioner::turnOn() {
+	setState(status, true);
+}
+void AirConditioner::turnOff() {
+	setState(status, false);
+}
+std::string_view AirConditioner::statusText() const {
+	if (status) {
+		return "AirConditioner is On";
+	}
+	return "AirConditioner is Off";
+}
@@ -0,0 +1,427 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <fstream>
+#include <future>
+#include <mutex>
+#include "device.h"
+#include "command.h"
+#include "controller.h"
+#include "scheduler.h"
+#include "observer.h"
+#include "pipeline.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+static int64_t nowNs() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+// Log-linear latency histogram: each power of two is split into 16 steps,
+// which keeps percentiles within ~6% without storing samples.
+class LatencyHistogram {
+	static constexpr int SubBits = 4;
+	static constexpr uint64_t SubCount = 1 << SubBits;
+	std::vector<uint64_t> counts = std::vector<uint64_t>(64 * SubCount, 0);
+	uint64_t total = 0;
+
+	static size_t bucketOf(uint64_t ns) {
+		if (ns < SubCount) return static_cast<size_t>(ns);
+		int msb = 63;
+		while (!(ns >> msb)) msb--;
+		int group = msb - SubBits + 1;
+		return static_cast<size_t>(group) * SubCount + ((ns >> (msb - SubBits)) & (SubCount - 1));
+	}
+
+	static uint64_t upperBound(size_t bucket) {
+		if (bucket < SubCount) return bucket;
+		uint64_t group = bucket / SubCount;
+		uint64_t sub = bucket % SubCount;
+		return (SubCount + sub + 1) << (group - 1);
+	}
+
+public:
+	void record(int64_t ns) {
+		counts[bucketOf(ns > 0 ? static_cast<uint64_t>(ns) : 0)]++;
+		total++;
+	}
+
+	void merge(const LatencyHistogram& other) {
+		for (size_t i = 0; i < counts.size(); i++) counts[i] += other.counts[i];
+		total += other.total;
+	}
+
+	uint64_t count() const { return total; }
+
+	double percentileUs(double p) const {
+		if (!total) return 0;
+		uint64_t rank = static_cast<uint64_t>(p * (total - 1)) + 1;
+		uint64_t seen = 0;
+		for (size_t i = 0; i < counts.size(); i++) {
+			seen += counts[i];
+			if (seen >= rank) return upperBound(i) / 1000.0;
+		}
+		return upperBound(counts.size() - 1) / 1000.0;
+	}
+};
+
+struct Options {
+	size_t devices = 100000;
+	size_t rooms = 1000;
+	size_t sensors = 1000;
+	double eventRate = 100;		// events per second per sensor, 0 = unthrottled
+	double duration = 2;		// seconds per phase
+	size_t producers = 4;
+	size_t sensorThreads = 2;
+	size_t busThreads = 2;
+	size_t shards = 2;
+	size_t scheduleRuns = 5;
+	size_t rulePeriodMs = 100;
+};
+
+static size_t rssBytes() {
+#ifdef __linux__
+	std::ifstream statm("/proc/self/statm");
+	size_t pages = 0, resident = 0;
+	statm >> pages >> resident;
+	return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+	return 0;
+#endif
+}
+
+static void report(const std::string& phase, uint64_t ops, double seconds, const LatencyHistogram& latency) {
+	std::cout << std::left << std::setw(16) << phase << std::right
+		<< std::setw(12) << ops
+		<< std::setw(14) << std::fixed << std::setprecision(0) << (seconds > 0 ? ops / seconds : 0)
+		<< std::setw(11) << std::setprecision(2) << latency.percentileUs(0.50)
+		<< std::setw(11) << latency.percentileUs(0.99)
+		<< std::setw(11) << latency.percentileUs(0.999) << "\n";
+}
+
+static double secondsSince(Clock::time_point begin) {
+	return std::chrono::duration<double>(Clock::now() - begin).count();
+}
+
+class LatencyObserver : public Observer {
+public:
+	LatencyHistogram latency;
+	uint64_t events = 0;
+
+	void update(const std::string&) override {}
+	void onEvents(const Event* batch, size_t count) override {
+		int64_t now = nowNs();
+		for (size_t i = 0; i < count; i++) {
+			latency.record(now - batch[i].timestamp);
+			events += batch[i].count;
+		}
+	}
+};
+
+static void runSensors(const Options& opt) {
+	std::vector<std::unique_ptr<LatencyObserver>> observers;
+	std::vector<std::unique_ptr<Subject>> sensors;
+	uint64_t published = 0;
+	uint64_t dropped = 0;
+	double elapsed = 0;
+	{
+		EventBus bus(opt.busThreads, 4096, 256);
+		TopicIndex topics(&bus);
+		for (size_t r = 0; r < opt.rooms; r++) {
+			observers.push_back(std::make_unique<LatencyObserver>());
+			topics.subscribe("home/room" + std::to_string(r) + "/#", observers.back().get());
+		}
+		observers.push_back(std::make_unique<LatencyObserver>());
+		topics.subscribe("home/*/door/*", observers.back().get());
+
+		for (size_t s = 0; s < opt.sensors; s++) {
+			sensors.push_back(std::make_unique<Subject>());
+			sensors.back()->attachTopics(topics, "home/room" + std::to_string(s % opt.rooms) + "/door/" + std::to_string(s));
+		}
+
+		std::atomic<bool> stop(false);
+		std::atomic<uint64_t> sent(0);
+		std::vector<std::thread> drivers;
+		size_t threads = std::max<size_t>(1, std::min(opt.sensorThreads, opt.sensors));
+		auto begin = Clock::now();
+		for (size_t t = 0; t < threads; t++) {
+			drivers.emplace_back([&, t] {
+				// Every sensor a thread owns fires once per round; rounds are paced to eventRate.
+				uint64_t local = 0;
+				auto period = opt.eventRate > 0 ? std::chrono::duration<double>(1.0 / opt.eventRate) : std::chrono::duration<double>(0);
+				Event event;
+				event.type = EventType::Motion;
+				for (uint64_t round = 0; !stop; round++) {
+					for (size_t s = t; s < sensors.size(); s += threads) {
+						event.source = static_cast<uint32_t>(s);
+						event.value = static_cast<int64_t>(round);
+						sensors[s]->notify(event);
+						local++;
+					}
+					if (opt.eventRate > 0) {
+						std::this_thread::sleep_until(begin + std::chrono::duration_cast<Clock::duration>(period * (round + 1)));
+					}
+				}
+				sent += local;
+			});
+		}
+		std::this_thread::sleep_for(std::chrono::duration<double>(opt.duration));
+		stop = true;
+		for (auto& d : drivers) d.join();
+		published = sent;
+		dropped = bus.dropped();
+		elapsed = secondsSince(begin);
+	}
+
+	LatencyHistogram latency;
+	for (auto& o : observers) latency.merge(o->latency);
+	report("sensor-events", published, elapsed, latency);
+	std::cout << "  (" << dropped << " deliveries dropped by back-pressure)\n";
+}
+
+static void runPipeline(const Options& opt, const std::vector<Device*>& devices) {
+	LatencyHistogram latency;
+	std::atomic<uint64_t> posted(0);
+	auto begin = Clock::now();
+	uint64_t coalesced = 0;
+	{
+		CommandPipeline pipeline(opt.shards);
+		std::atomic<bool> stop(false);
+		std::vector<std::thread> producers;
+		std::vector<LatencyHistogram> perThread(opt.producers);
+		for (size_t p = 0; p < opt.producers; p++) {
+			producers.emplace_back([&, p] {
+				std::mt19937_64 rng(p + 1);
+				uint64_t local = 0;
+				while (!stop) {
+					for (int i = 0; i < 1023; i++) {
+						Device* dev = devices[rng() % devices.size()];
+						pipeline.post(dev, (local + i) & 1 ? CommandOp::TurnOn : CommandOp::TurnOff);
+					}
+					// Sample end-to-end latency on one command in every 1024.
+					int64_t t0 = nowNs();
+					pipeline.submit(devices[rng() % devices.size()], CommandOp::TurnOn).wait();
+					perThread[p].record(nowNs() - t0);
+					local += 1024;
+				}
+				posted += local;
+			});
+		}
+		std::this_thread::sleep_for(std::chrono::duration<double>(opt.duration));
+		stop = true;
+		for (auto& t : producers) t.join();
+		for (auto& h : perThread) latency.merge(h);
+		coalesced = pipeline.coalesced();
+	}
+	report("pipeline-cmds", posted, secondsSince(begin), latency);
+	std::cout << "  (" << coalesced << " commands coalesced)\n";
+}
+
+static void runRemote(const Options& opt, const std::vector<std::pair<std::string, std::shared_ptr<Device>>>& named) {
+	Remote remote(4096);
+	std::vector<uint32_t> ids;
+	size_t bound = std::min<size_t>(named.size(), 65536);
+	for (size_t i = 0; i < bound; i++) {
+		ids.push_back(remote.bindDevice(named[i].first, named[i].second));
+	}
+
+	LatencyHistogram latency;
+	std::mt19937_64 rng(99);
+	uint64_t ops = 0;
+	auto begin = Clock::now();
+	auto end = begin + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(opt.duration));
+	while (Clock::now() < end) {
+		for (int i = 0; i < 256; i++, ops++) {
+			int64_t t0 = (i & 15) == 0 ? nowNs() : 0;
+			uint32_t id = ids[rng() % ids.size()];
+			if (i % 64 == 0) {
+				remote.beginBatch();
+				for (int k = 0; k < 8; k++) remote.execute(ids[(id + k) % ids.size()], CommandOp::TurnOff);
+				remote.endBatch();
+			}
+			else if (i % 50 == 0) {
+				remote.undoCmd(3);
+				remote.redoCmd(2);
+			}
+			else {
+				remote.execute(id, i & 1 ? CommandOp::TurnOn : CommandOp::TurnOff);
+			}
+			if (t0) latency.record(nowNs() - t0);
+		}
+	}
+	report("remote-cmds", ops, secondsSince(begin), latency);
+}
+
+// Turns off every light in one room; records how late each periodic firing ran.
+class RoomLightsOff : public ScheduleStrategy {
+	std::vector<Device*> lights;
+	int64_t firstDue;
+	int64_t periodNs;
+	std::atomic<int64_t> fired{ 0 };
+	LatencyHistogram& lag;
+	std::mutex& lagMutex;
+public:
+	RoomLightsOff(std::vector<Device*> roomLights, int64_t due, int64_t period, LatencyHistogram& h, std::mutex& m)
+		: lights(std::move(roomLights)), firstDue(due), periodNs(period), lag(h), lagMutex(m) {}
+
+	void executeSchedule(std::map<std::string, std::shared_ptr<Device>>&) override {
+		int64_t due = firstDue + periodNs * fired++;
+		int64_t late = nowNs() - due;
+		for (Device* d : lights) d->turnOff();
+		std::lock_guard<std::mutex> lock(lagMutex);
+		lag.record(late);
+	}
+};
+
+static void runSchedules(const Options& opt, CentralController& controller, const std::vector<Device*>& devices) {
+	LatencyHistogram passes;
+	Scheduler scheduler;
+	scheduler.setStrategy(std::make_shared<NightTimeSchedule>());
+	auto begin = Clock::now();
+	for (size_t i = 0; i < opt.scheduleRuns; i++) {
+		int64_t t0 = nowNs();
+		scheduler.run(controller.getAllDevices());
+		passes.record(nowNs() - t0);
+	}
+	report("schedule-pass", opt.scheduleRuns, secondsSince(begin), passes);
+
+	std::vector<std::vector<Device*>> roomLights(opt.rooms);
+	for (size_t i = 0; i < devices.size(); i++) {
+		if (devices[i]->getType() == DeviceType::Light) roomLights[i % opt.rooms].push_back(devices[i]);
+	}
+
+	LatencyHistogram lag;
+	std::mutex lagMutex;
+	begin = Clock::now();
+	{
+		ScheduleEngine engine(controller.getAllDevices());
+		auto period = std::chrono::milliseconds(opt.rulePeriodMs);
+		int64_t periodNs = std::chrono::duration_cast<std::chrono::nanoseconds>(period).count();
+		for (size_t r = 0; r < opt.rooms; r++) {
+			int64_t due = nowNs() + periodNs;
+			engine.addRule(std::make_shared<RoomLightsOff>(roomLights[r], due, periodNs, lag, lagMutex), period, period);
+		}
+		std::this_thread::sleep_for(std::chrono::duration<double>(opt.duration));
+	}
+	report("schedule-rules", lag.count(), secondsSince(begin), lag);
+}
+
+// Dashboard poll: one full export, then deltas after 1% of devices change.
+static void runTelemetry(const Options& opt, CentralController& controller, const std::vector<Device*>& devices) {
+	std::vector<char> buffer;
+	LatencyHistogram full;
+	LatencyHistogram delta;
+	uint64_t cursor = 0;
+	size_t fullBytes = 0;
+	size_t deltaBytes = 0;
+	std::mt19937_64 rng(7);
+
+	auto begin = Clock::now();
+	for (size_t i = 0; i < opt.scheduleRuns; i++) {
+		int64_t t0 = nowNs();
+		cursor = controller.exportTelemetry(buffer);
+		full.record(nowNs() - t0);
+		fullBytes = buffer.size();
+	}
+	report("telemetry-full", opt.scheduleRuns, secondsSince(begin), full);
+
+	double toggleSeconds = 0;
+	begin = Clock::now();
+	for (size_t i = 0; i < opt.scheduleRuns; i++) {
+		auto toggleBegin = Clock::now();
+		for (size_t k = 0; k < devices.size() / 100 + 1; k++) {
+			Device* dev = devices[rng() % devices.size()];
+			if (dev->isOn()) dev->turnOff();
+			else dev->turnOn();
+		}
+		toggleSeconds += secondsSince(toggleBegin);
+		int64_t t0 = nowNs();
+		cursor = controller.exportTelemetry(buffer, cursor);
+		delta.record(nowNs() - t0);
+		deltaBytes = buffer.size();
+	}
+	report("telemetry-delta", opt.scheduleRuns, secondsSince(begin) - toggleSeconds, delta);
+	std::cout << "  (full export " << fullBytes << " bytes, 1% delta " << deltaBytes << " bytes)\n";
+}
+
+static void usage() {
+	std::cout << "LoadSimulator [--devices N] [--rooms N] [--sensors N] [--event-rate HZ] [--duration SEC]\n"
+		"              [--producers N] [--shards N] [--sensor-threads N] [--bus-threads N]\n"
+		"              [--schedule-runs N] [--rule-period MS]\n";
+}
+
+int main(int argc, char* argv[]) {
+	Options opt;
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--help" || i + 1 >= argc) {
+			usage();
+			return arg == "--help" ? 0 : 1;
+		}
+		std::string value = argv[++i];
+		if (arg == "--devices") opt.devices = std::stoul(value);
+		else if (arg == "--rooms") opt.rooms = std::stoul(value);
+		else if (arg == "--sensors") opt.sensors = std::stoul(value);
+		else if (arg == "--event-rate") opt.eventRate = std::stod(value);
+		else if (arg == "--duration") opt.duration = std::stod(value);
+		else if (arg == "--producers") opt.producers = std::stoul(value);
+		else if (arg == "--shards") opt.shards = std::stoul(value);
+		else if (arg == "--sensor-threads") opt.sensorThreads = std::stoul(value);
+		else if (arg == "--bus-threads") opt.busThreads = std::stoul(value);
+		else if (arg == "--schedule-runs") opt.scheduleRuns = std::stoul(value);
+		else if (arg == "--rule-period") opt.rulePeriodMs = std::stoul(value);
+		else {
+			usage();
+			return 1;
+		}
+	}
+	if (!opt.devices || !opt.rooms) {
+		usage();
+		return 1;
+	}
+
+	auto& controller = CentralController::getInstance();
+	const char* types[] = { "Light", "Fan", "AirConditioner" };
+	std::vector<Device*> devices;
+	std::vector<std::pair<std::string, std::shared_ptr<Device>>> named;
+	devices.reserve(opt.devices);
+	named.reserve(opt.devices);
+
+	size_t rssBefore = rssBytes();
+	for (size_t i = 0; i < opt.devices; i++) {
+		std::string name = "home/room" + std::to_string(i % opt.rooms) + "/" + types[i % 3] + std::to_string(i);
+		auto dev = DeviceFactory::createDevice(types[i % 3]);
+		controller.registerDevice(name, dev);
+		devices.push_back(dev.get());
+		named.emplace_back(name, dev);
+	}
+	size_t rssAfter = rssBytes();
+
+	std::cout << opt.devices << " devices in " << opt.rooms << " rooms, " << opt.sensors << " sensors, "
+		<< opt.duration << "s per phase\n";
+	if (rssAfter > rssBefore) {
+		std::cout << "memory/device: " << (rssAfter - rssBefore) / opt.devices
+			<< " bytes (RSS, includes the registry map and name)\n";
+	}
+	std::cout << std::left << std::setw(16) << "phase" << std::right << std::setw(12) << "ops"
+		<< std::setw(14) << "ops/s" << std::setw(11) << "p50(us)" << std::setw(11) << "p99(us)"
+		<< std::setw(11) << "p999(us)" << "\n";
+
+	runSensors(opt);
+	runPipeline(opt, devices);
+	runRemote(opt, named);
+	runSchedules(opt, controller, devices);
+	runTelemetry(opt, controller, devices);
+	return 0;
+}
@@ -0,0 +1,89 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <thread>
+#include "threadpool.h"
+#include "timingwheel.h"
+
+using Clock = std::chrono::steady_clock;
+
+static double nsPerOp(Clock::duration d, size_t ops) {
+	return std::chrono::duration<double, std::nano>(d).count() / ops;
+}
+
+int main(int argc, char* argv[]) {
+	const size_t RULES = argc > 1 ? std::stoul(argv[1]) : 1000000;
+
+	ThreadPool pool(4);
+	std::atomic<size_t> fired(0);
+	std::atomic<long long> maxLagUs(0);
+
+	// Insert / cancel cost with rules spread from 1ms to 1 day, so every wheel level is used.
+	{
+		TimingWheel wheel(pool);
+		wheel.reserve(RULES);
+		std::mt19937_64 rng(42);
+		std::uniform_int_distribution<int> delayMs(1, 24 * 60 * 60 * 1000);
+		std::vector<TimingWheel::TimerId> ids(RULES);
+
+		auto begin = Clock::now();
+		for (size_t i = 0; i < RULES; i++) {
+			ids[i] = wheel.schedule(std::chrono::milliseconds(delayMs(rng)), [&fired] { fired++; });
+		}
+		auto inserted = Clock::now();
+		for (size_t i = 0; i < RULES; i += 2) {
+			wheel.cancel(ids[i]);
+		}
+		auto cancelled = Clock::now();
+
+		std::cout << "schedule: " << nsPerOp(inserted - begin, RULES) << " ns/op\n";
+		std::cout << "cancel:   " << nsPerOp(cancelled - inserted, RULES / 2) << " ns/op\n";
+
+		begin = Clock::now();
+		size_t expired = wheel.advance(Clock::now() + std::chrono::hours(25));
+		auto drained = Clock::now();
+		std::cout << "expire:   " << nsPerOp(drained - begin, expired) << " ns/op (" << expired << " rules)\n";
+	}
+
+	// Idle cost: a full wheel of far-future rules should not burn CPU while waiting.
+	{
+		TimingWheel wheel(pool);
+		for (size_t i = 0; i < RULES; i++) {
+			wheel.schedule(std::chrono::hours(1) + std::chrono::milliseconds(i), [] {});
+		}
+		wheel.start();
+		std::clock_t cpuBegin = std::clock();
+		std::this_thread::sleep_for(std::chrono::seconds(1));
+		std::clock_t cpuEnd = std::clock();
+		std::cout << "idle cpu: " << 1000.0 * (cpuEnd - cpuBegin) / CLOCKS_PER_SEC << " ms over 1s with "
+			<< wheel.pending() << " pending rules\n";
+	}
+
+	// Real-time firing: RULES rules due within the next two seconds.
+	{
+		fired = 0;
+		TimingWheel wheel(pool);
+		wheel.reserve(RULES);
+		std::mt19937_64 rng(7);
+		std::uniform_int_distribution<int> delayMs(100, 2000);
+		for (size_t i = 0; i < RULES; i++) {
+			auto due = Clock::now() + std::chrono::milliseconds(delayMs(rng));
+			wheel.scheduleAt(due, [&fired, &maxLagUs, due] {
+				long long lag = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - due).count();
+				long long seen = maxLagUs.load();
+				while (lag > seen && !maxLagUs.compare_exchange_weak(seen, lag)) {}
+				fired++;
+			});
+		}
+		wheel.start();
+		while (fired < RULES) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		std::cout << "fired:    " << fired << " rules, max lag " << maxLagUs / 1000.0 << " ms\n";
+	}
+
+	return 0;
+}
@@ -0,0 +1,63 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cstdio>
+#include "controller.h"
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point begin) {
+	return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+}
+
+int main(int argc, char* argv[]) {
+	const size_t DEVICES = argc > 1 ? std::stoul(argv[1]) : 1000000;
+	const std::string snapshotPath = "devices.snapshot";
+	const std::string journalPath = "devices.journal";
+	std::remove(snapshotPath.c_str());
+	std::remove(journalPath.c_str());
+
+	auto& controller = CentralController::getInstance();
+	const char* types[] = { "Light", "Fan", "AirConditioner" };
+
+	auto begin = Clock::now();
+	for (size_t i = 0; i < DEVICES; i++) {
+		auto dev = DeviceFactory::createDevice(types[i % 3]);
+		if (i % 2) dev->turnOn();
+		controller.registerDevice("room" + std::to_string(i / 3) + "/" + types[i % 3], dev);
+	}
+	std::cout << "register:   " << msSince(begin) << " ms for " << DEVICES << " devices\n";
+
+	begin = Clock::now();
+	controller.saveSnapshot(snapshotPath);
+	std::cout << "snapshot:   " << msSince(begin) << " ms\n";
+
+	controller.enableJournal(journalPath);
+	controller.getDevice("room0/Light")->turnOn();
+	controller.getDevice("room1/Fan")->turnOff();
+	controller.registerDevice("garage/Light", DeviceFactory::createDevice("Light"));
+	std::cout << "journaled:  " << controller.journalChanges() << " state changes\n";
+
+	// The first restart also pays for tearing down the 1M-device registry built
+	// above; the second one is what a fresh process sees.
+	controller.coldStart(snapshotPath, journalPath);
+	begin = Clock::now();
+	controller.coldStart(snapshotPath, journalPath);
+	std::cout << "cold start: " << msSince(begin) << " ms, " << controller.deviceCount() << " devices\n";
+
+	begin = Clock::now();
+	size_t on = 0;
+	for (size_t i = 0; i < 1000; i++) {
+		auto dev = controller.getDevice("room" + std::to_string(i * 97 % (DEVICES / 3)) + "/Light");
+		if (dev && dev->isOn()) on++;
+	}
+	std::cout << "lookup:     " << msSince(begin) << " us/lookup (first touch), " << on << " on\n";
+	std::cout << "restored:   room0/Light " << controller.getDevice("room0/Light")->statusText()
+		<< ", room1/Fan " << controller.getDevice("room1/Fan")->statusText()
+		<< ", garage/Light " << (controller.getDevice("garage/Light") ? "present" : "missing") << "\n";
+
+	begin = Clock::now();
+	size_t all = controller.getAllDevices().size();
+	std::cout << "materialize all: " << msSince(begin) << " ms for " << all << " devices\n";
+	return 0;
+}
@@ -0,0 +1,380 @@
+#ifndef COMMAND_H
+#define COMMAND_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <functional>
+#include <unordered_map>
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include "device.h"
+
+enum class CommandOp : uint8_t {
+	TurnOn, TurnOff, Custom,
+	// Journal-only records
+	Bind, Undo, Redo, BatchBegin, BatchEnd
+};
+
+class Command {
+public:
+	virtual void execute() = 0;
+	virtual void undo() = 0;
+	virtual ~Command() {}
+};
+
+// A command that only flips one device; Remote stores these as compact records.
+class DeviceCommand : public Command {
+protected:
+	std::shared_ptr<Device> device;
+public:
+	DeviceCommand(std::shared_ptr<Device> dev) : device(dev) {}
+	const std::shared_ptr<Device>& target() const { return device; }
+	virtual CommandOp op() const = 0;
+};
+
+class TurnOnCommand : public DeviceCommand {
+public :
+	TurnOnCommand(std::shared_ptr<Device> dev) : DeviceCommand(dev) {}
+	void execute() override{
+		device->turnOn();
+	}
+	void undo() override{
+		device->turnOff();
+	}
+	CommandOp op() const override { return CommandOp::TurnOn; }
+};
+
+class TurnOffCommand : public DeviceCommand {
+public:
+	TurnOffCommand(std::shared_ptr<Device> dev) : DeviceCommand(dev) {}
+	void execute() override {
+		device->turnOff();
+	}
+	void undo() override {
+		device->turnOn();
+	}
+	CommandOp op() const override { return CommandOp::TurnOff; }
+};
+
+struct CommandRecord {
+	uint32_t device = 0;	// Remote device id (or step count for Undo/Redo)
+	CommandOp op = CommandOp::Custom;
+	uint8_t reserved = 0;
+	uint16_t unit = 1;		// size of the undo unit this record belongs to
+};
+static_assert(sizeof(CommandRecord) == 8, "CommandRecord is written to the journal as-is");
+
+// Remote keeps its history in a fixed ring of 8-byte records instead of one
+// heap object per command. Once the ring is full the oldest undo unit is
+// evicted. beginBatch()/endBatch() group commands into one undo unit, and an
+// optional journal of the same records can be replayed at startup.
+class Remote {
+public:
+	Remote(size_t historyCapacity = 4096);
+	~Remote();
+
+	uint32_t bindDevice(const std::string& name, std::shared_ptr<Device> dev);
+
+	void executeCmd(std::shared_ptr<Command> cmd);
+	void execute(uint32_t device, CommandOp op);
+
+	void beginBatch();
+	void endBatch();
+
+	size_t undoCmd(size_t steps = 1);
+	size_t redoCmd(size_t steps = 1);
+
+	// Routes device on/off work somewhere other than the calling thread,
+	// e.g. a CommandPipeline; history and journal stay with the Remote.
+	void setDispatcher(std::function<void(Device*, CommandOp)> dispatcher) { dispatch = std::move(dispatcher); }
+
+	void openJournal(const std::string& path);
+	size_t replayJournal(const std::string& path,
+		const std::function<std::shared_ptr<Device>(const std::string&)>& resolve);
+
+	size_t undoDepth() const { return static_cast<size_t>(cursor - begin); }
+	size_t redoDepth() const { return static_cast<size_t>(end - cursor); }
+
+private:
+	static constexpr uint32_t JournalMagic = 0x4A544D52;	// "RMTJ"
+	static constexpr uint64_t NoBatch = UINT64_MAX;
+
+	const size_t capacity;
+	std::vector<CommandRecord> ring;
+	std::vector<std::shared_ptr<Command>> customs;
+	uint64_t begin = 0;
+	uint64_t cursor = 0;
+	uint64_t end = 0;
+	uint64_t batchStart = NoBatch;
+
+	std::vector<std::shared_ptr<Device>> devices;
+	std::vector<std::string> names;
+	std::unordered_map<Device*, uint32_t> deviceIds;
+
+	std::ofstream journal;
+	bool replaying = false;
+	std::function<void(Device*, CommandOp)> dispatch;
+
+	CommandRecord& at(uint64_t pos) { return ring[pos % capacity]; }
+	void checkRoom() const;
+	void push(const CommandRecord& record, std::shared_ptr<Command> custom);
+	void evictOldestUnit();
+	void apply(uint64_t pos, bool forward);
+	void writeJournal(const CommandRecord& record, const std::string* name = nullptr);
+};
+
+inline Remote::Remote(size_t historyCapacity)
+	: capacity(historyCapacity ? historyCapacity : 1), ring(capacity), customs(capacity) {
+}
+
+inline Remote::~Remote() {
+	if (batchStart != NoBatch) endBatch();
+}
+
+inline uint32_t Remote::bindDevice(const std::string& name, std::shared_ptr<Device> dev) {
+	auto it = deviceIds.find(dev.get());
+	if (it != deviceIds.end()) return it->second;
+
+	uint32_t id = static_cast<uint32_t>(devices.size());
+	devices.push_back(dev);
+	names.push_back(name);
+	deviceIds.emplace(dev.get(), id);
+
+	// Unnamed devices cannot be resolved at replay, so they are not journaled;
+	// their commands replay as no-op history entries.
+	if (!name.empty()) {
+		CommandRecord record;
+		record.device = id;
+		record.op = CommandOp::Bind;
+		writeJournal(record, &names.back());
+	}
+	return id;
+}
+
+inline void Remote::executeCmd(std::shared_ptr<Command> cmd) {
+	if (auto deviceCmd = dynamic_cast<DeviceCommand*>(cmd.get())) {
+		execute(bindDevice("", deviceCmd->target()), deviceCmd->op());
+		return;
+	}
+	checkRoom();
+	cmd->execute();
+	CommandRecord record;
+	record.op = CommandOp::Custom;
+	push(record, std::move(cmd));
+	writeJournal(record);
+}
+
+inline void Remote::execute(uint32_t device, CommandOp op) {
+	if (device >= devices.size()) throw std::out_of_range("Unknown device id");
+	if (op != CommandOp::TurnOn && op != CommandOp::TurnOff) throw std::invalid_argument("Not a device command");
+
+	CommandRecord record;
+	record.device = device;
+	record.op = op;
+	push(record, nullptr);
+	apply(cursor - 1, true);
+	writeJournal(record);
+}
+
+// Throws, before anything has run or changed, if one more command would not
+// fit in the open batch; endBatch() and the destructor then never fail.
+inline void Remote::checkRoom() const {
+	if (batchStart == NoBatch) return;
+	if (cursor - batchStart >= UINT16_MAX) {
+		throw std::length_error("Batch is too large for one undo unit");
+	}
+	if (cursor - begin == capacity && begin == batchStart) {
+		throw std::length_error("Batch does not fit in the command history");
+	}
+}
+
+inline void Remote::push(const CommandRecord& record, std::shared_ptr<Command> custom) {
+	checkRoom();
+	// A new command discards whatever could still have been redone.
+	for (uint64_t pos = cursor; pos < end; pos++) customs[pos % capacity].reset();
+	end = cursor;
+
+	if (cursor - begin == capacity) evictOldestUnit();
+	at(cursor) = record;
+	customs[cursor % capacity] = std::move(custom);
+	if (batchStart != NoBatch) at(cursor).unit = 0;
+	cursor++;
+	end = cursor;
+}
+
+inline void Remote::evictOldestUnit() {
+	uint16_t unit = at(begin).unit;
+	for (uint16_t i = 0; i < unit; i++) customs[(begin + i) % capacity].reset();
+	begin += unit;
+}
+
+inline void Remote::beginBatch() {
+	if (batchStart != NoBatch) return;
+	batchStart = cursor;
+	CommandRecord record;
+	record.op = CommandOp::BatchBegin;
+	writeJournal(record);
+}
+
+inline void Remote::endBatch() {
+	if (batchStart == NoBatch) return;
+	uint64_t size = cursor - batchStart;	// checkRoom() keeps this within uint16_t
+	for (uint64_t pos = batchStart; pos < cursor; pos++) {
+		at(pos).unit = static_cast<uint16_t>(size);
+	}
+	batchStart = NoBatch;
+	CommandRecord record;
+	record.op = CommandOp::BatchEnd;
+	writeJournal(record);
+	if (journal.is_open()) journal.flush();
+}
+
+inline void Remote::apply(uint64_t pos, bool forward) {
+	const CommandRecord& record = at(pos);
+	if (record.op == CommandOp::Custom) {
+		// Replayed custom commands have no object and only hold their slot.
+		if (Command* cmd = customs[pos % capacity].get()) {
+			if (forward) cmd->execute();
+			else cmd->undo();
+		}
+		return;
+	}
+	bool on = (record.op == CommandOp::TurnOn) == forward;
+	if (dispatch) dispatch(devices[record.device].get(), on ? CommandOp::TurnOn : CommandOp::TurnOff);
+	else if (on) devices[record.device]->turnOn();
+	else devices[record.device]->turnOff();
+}
+
+inline size_t Remote::undoCmd(size_t steps) {
+	endBatch();
+	size_t done = 0;
+	for (; done < steps && cursor > begin; done++) {
+		uint16_t unit = at(cursor - 1).unit;
+		for (uint16_t i = 0; i < unit; i++) {
+			apply(cursor - 1 - i, false);
+		}
+		cursor -= unit;
+	}
+	if (done) {
+		CommandRecord record;
+		record.device = static_cast<uint32_t>(done);
+		record.op = CommandOp::Undo;
+		writeJournal(record);
+	}
+	return done;
+}
+
+inline size_t Remote::redoCmd(size_t steps) {
+	endBatch();
+	size_t done = 0;
+	for (; done < steps && cursor < end; done++) {
+		uint16_t unit = at(cursor).unit;
+		for (uint16_t i = 0; i < unit; i++) {
+			apply(cursor + i, true);
+		}
+		cursor += unit;
+	}
+	if (done) {
+		CommandRecord record;
+		record.device = static_cast<uint32_t>(done);
+		record.op = CommandOp::Redo;
+		writeJournal(record);
+	}
+	return done;
+}
+
+inline void Remote::writeJournal(const CommandRecord& record, const std::string* name) {
+	if (!journal.is_open() || replaying) return;
+	CommandRecord out = record;
+	if (name) out.unit = static_cast<uint16_t>(std::min<size_t>(name->size(), UINT16_MAX));
+	journal.write(reinterpret_cast<const char*>(&out), sizeof(out));
+	if (name) journal.write(name->data(), out.unit);
+}
+
+// Appends to the journal at path. Devices bound before this call are written
+// first so the file is self-describing.
+inline void Remote::openJournal(const std::string& path) {
+	journal.open(path, std::ios::binary | std::ios::app);
+	if (!journal.is_open()) {
+		throw std::runtime_error("Failed to open the command journal");
+	}
+	if (journal.tellp() == 0) {
+		uint32_t header[2] = { JournalMagic, 1 };
+		journal.write(reinterpret_cast<const char*>(header), sizeof(header));
+	}
+	for (uint32_t id = 0; id < devices.size(); id++) {
+		if (names[id].empty()) continue;
+		CommandRecord record;
+		record.device = id;
+		record.op = CommandOp::Bind;
+		writeJournal(record, &names[id]);
+	}
+	journal.flush();
+}
+
+// Re-applies a journal written by openJournal(). Device names are resolved
+// through 'resolve'. Custom commands, and commands for devices it cannot find,
+// come back as no-op history entries so later Undo/Redo steps still land on
+// the same commands.
+inline size_t Remote::replayJournal(const std::string& path,
+	const std::function<std::shared_ptr<Device>(const std::string&)>& resolve) {
+	std::ifstream in(path, std::ios::binary | std::ios::ate);
+	if (!in.is_open()) return 0;
+	std::vector<char> data(static_cast<size_t>(in.tellg()));
+	in.seekg(0);
+	in.read(data.data(), data.size());
+
+	uint32_t header[2] = {};
+	if (data.size() < sizeof(header)) return 0;
+	std::memcpy(header, data.data(), sizeof(header));
+	if (header[0] != JournalMagic) {
+		throw std::runtime_error("Not a command journal");
+	}
+
+	replaying = true;
+	std::vector<int64_t> idMap;
+	size_t applied = 0;
+	size_t pos = sizeof(header);
+	while (pos + sizeof(CommandRecord) <= data.size()) {
+		CommandRecord record;
+		std::memcpy(&record, data.data() + pos, sizeof(record));
+		pos += sizeof(record);
+
+		switch (record.op) {
+		case CommandOp::Bind: {
+			if (pos + record.unit > data.size()) break;
+			std::string name(data.data() + pos, record.unit);
+			pos += record.unit;
+			if (record.device >= idMap.size()) idMap.resize(record.device + 1, -1);
+			std::shared_ptr<Device> dev = name.empty() ? nullptr : resolve(name);
+			idMap[record.device] = dev ? static_cast<int64_t>(bindDevice(name, dev)) : -1;
+			break;
+		}
+		case CommandOp::TurnOn:
+		case CommandOp::TurnOff:
+			if (record.device < idMap.size() && idMap[record.device] >= 0) {
+				execute(static_cast<uint32_t>(idMap[record.device]), record.op);
+				applied++;
+			}
+			else {
+				push(CommandRecord(), nullptr);
+			}
+			break;
+		case CommandOp::Custom: push(CommandRecord(), nullptr); break;
+		case CommandOp::Undo: undoCmd(record.device); applied++; break;
+		case CommandOp::Redo: redoCmd(record.device); applied++; break;
+		case CommandOp::BatchBegin: beginBatch(); break;
+		case CommandOp::BatchEnd: endBatch(); break;
+		default: break;
+		}
+	}
+	endBatch();
+	replaying = false;
+	return applied;
+}
+
+#endif
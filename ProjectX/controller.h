@@ -0,0 +1,454 @@
+#ifndef CONTROLLER_H
+#define CONTROLLER_H
+
+#include <string>
+#include <string_view>
+#include <map>
+#include <memory>
+#include <vector>
+#include <fstream>
+#include <unordered_map>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include "device.h"
+#include "mappedfile.h"
+
+class DeviceFactory {
+public:
+	static std::shared_ptr<Device> createDevice(const std::string& type) {
+		if (type == "Light") return std::make_shared<Light>();
+		if (type == "Fan") return std::make_shared<Fan>();
+		if (type == "AirConditioner") return std::make_shared<AirConditioner>();
+		return nullptr;
+	}
+
+	static std::shared_ptr<Device> createDevice(DeviceType type) {
+		switch (type) {
+		case DeviceType::Light: return std::make_shared<Light>();
+		case DeviceType::Fan: return std::make_shared<Fan>();
+		case DeviceType::AirConditioner: return std::make_shared<AirConditioner>();
+		default: return nullptr;
+		}
+	}
+};
+
+// Snapshot file: header, entries sorted by name, then the packed name bytes.
+struct SnapshotHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t deviceCount;
+	uint64_t namesOffset;
+	uint64_t namesSize;
+};
+
+struct SnapshotEntry {
+	uint32_t nameOffset;
+	uint16_t nameLength;
+	DeviceType type;
+	uint8_t on;
+};
+
+// Telemetry export: header, then the columns nameEnd[deviceCount] (uint32,
+// end offset of each name in the names block), type[deviceCount] and
+// on[deviceCount] (one byte each), then namesSize bytes of names. Sequences
+// restart with the process: a consumer holding a cursor from another epoch
+// must ask for a full export instead of a delta.
+struct TelemetryHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t epoch;			// Device::sequenceEpoch() of the exporting process
+	uint64_t sinceSequence;	// 0 for a full export
+	uint64_t sequence;		// pass as 'since' to get the next delta
+	uint64_t deviceCount;
+	uint64_t namesSize;
+};
+
+// Delta journal record, followed by nameLength bytes of name.
+struct DeviceJournalRecord {
+	enum Kind : uint8_t { Register, State };
+	Kind kind;
+	DeviceType type;
+	uint8_t on;
+	uint8_t reserved;
+	uint32_t nameLength;
+};
+
+class CentralController {
+	std::map<std::string, std::shared_ptr<Device>> devices;
+
+	// Cold-start state: devices that only exist in the mapped snapshot are
+	// materialized into 'devices' the first time someone asks for them.
+	MappedFile snapshot;
+	const SnapshotEntry* entries = nullptr;
+	const char* names = nullptr;
+	size_t entryCount = 0;
+	size_t shadowed = 0;	// snapshot entries that now also live in 'devices'
+	uint64_t snapshotSequence = 0;	// change sequence of entries that only live in the snapshot
+
+	std::ofstream journal;
+	std::string journalPath;
+	std::unordered_map<Device*, bool> persisted;	// state as of the last snapshot/journal write
+
+	static constexpr uint32_t SnapshotMagic = 0x504E5343;	// "CSNP"
+	static constexpr uint32_t TelemetryMagic = 0x4D4C5443;	// "CTLM"
+
+	struct TelemetryRow {
+		std::string_view name;
+		DeviceType type;
+		bool on;
+	};
+	std::vector<TelemetryRow> telemetryRows;	// reused between exports
+
+	CentralController() {}
+
+	std::string_view entryName(const SnapshotEntry& e) const {
+		return std::string_view(names + e.nameOffset, e.nameLength);
+	}
+	const SnapshotEntry* findEntry(std::string_view name) const;
+	std::shared_ptr<Device> materialize(const SnapshotEntry& e, std::map<std::string, std::shared_ptr<Device>>::iterator hint);
+	bool mapSnapshot(const std::string& path);
+	void closeSnapshot();
+	template<class Fn> void forEachDevice(Fn fn) const;
+	void writeJournal(DeviceJournalRecord::Kind kind, const std::string& name, const Device& dev);
+	void replayJournal(const std::string& path);
+
+public:
+	static CentralController& getInstance() {
+		static CentralController instance;
+		return instance;
+	}
+
+	void registerDevice(const std::string& name, std::shared_ptr<Device> dev);
+	std::shared_ptr<Device> getDevice(const std::string& name);
+	std::map<std::string, std::shared_ptr<Device>>& getAllDevices();
+	size_t deviceCount() const { return devices.size() + entryCount - shadowed; }
+
+	bool saveSnapshot(const std::string& path);
+	bool coldStart(const std::string& snapshotPath, const std::string& journalPath);
+	void enableJournal(const std::string& path);
+	size_t journalChanges();
+
+	uint64_t exportTelemetry(std::vector<char>& out, uint64_t sinceSequence = 0);
+};
+
+inline const SnapshotEntry* CentralController::findEntry(std::string_view name) const {
+	size_t lo = 0, hi = entryCount;
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		int cmp = entryName(entries[mid]).compare(name);
+		if (cmp == 0) return &entries[mid];
+		if (cmp < 0) lo = mid + 1;
+		else hi = mid;
+	}
+	return nullptr;
+}
+
+inline std::shared_ptr<Device> CentralController::materialize(const SnapshotEntry& e,
+	std::map<std::string, std::shared_ptr<Device>>::iterator hint) {
+	std::shared_ptr<Device> dev = DeviceFactory::createDevice(e.type);
+	if (!dev) return nullptr;
+	if (e.on) dev->turnOn();
+	// Not a change: exports must keep treating it as part of the snapshot.
+	dev->restoreChange(snapshotSequence);
+	devices.emplace_hint(hint, std::string(entryName(e)), dev);
+	persisted[dev.get()] = e.on != 0;
+	shadowed++;
+	return dev;
+}
+
+inline void CentralController::registerDevice(const std::string& name, std::shared_ptr<Device> dev) {
+	auto it = devices.find(name);
+	if (it != devices.end()) {
+		persisted.erase(it->second.get());
+		it->second = dev;
+	}
+	else {
+		if (entries && findEntry(name)) shadowed++;
+		devices.emplace(name, dev);
+	}
+	persisted[dev.get()] = dev->isOn();
+	writeJournal(DeviceJournalRecord::Register, name, *dev);
+}
+
+inline std::shared_ptr<Device> CentralController::getDevice(const std::string& name) {
+	auto it = devices.lower_bound(name);
+	if (it != devices.end() && it->first == name) return it->second;
+	if (entries) {
+		if (const SnapshotEntry* e = findEntry(name)) return materialize(*e, it);
+	}
+	return nullptr;
+}
+
+inline std::map<std::string, std::shared_ptr<Device>>& CentralController::getAllDevices() {
+	if (shadowed < entryCount) {
+		auto it = devices.begin();
+		for (size_t i = 0; i < entryCount; i++) {
+			std::string_view name = entryName(entries[i]);
+			while (it != devices.end() && std::string_view(it->first) < name) ++it;
+			if (it == devices.end() || std::string_view(it->first) != name) {
+				materialize(entries[i], it);
+			}
+		}
+	}
+	return devices;
+}
+
+// Writes the whole registry (live devices merged with snapshot-only ones) to
+// path, then re-maps it as the current snapshot and restarts the journal.
+// Fails, leaving the registry and the old files alone, if a name does not fit
+// the entry format or the new file cannot be written and mapped.
+inline bool CentralController::saveSnapshot(const std::string& path) {
+	std::vector<SnapshotEntry> out;
+	std::string nameBlob;
+	out.reserve(deviceCount());
+
+	bool fits = true;
+	forEachDevice([&](std::string_view name, DeviceType type, bool on, uint64_t) {
+		if (name.size() > UINT16_MAX || nameBlob.size() > UINT32_MAX) {
+			fits = false;
+			return;
+		}
+		SnapshotEntry e;
+		e.nameOffset = static_cast<uint32_t>(nameBlob.size());
+		e.nameLength = static_cast<uint16_t>(name.size());
+		e.type = type;
+		e.on = on ? 1 : 0;
+		nameBlob.append(name.data(), name.size());
+		out.push_back(e);
+	});
+	if (!fits) return false;
+
+	SnapshotHeader header;
+	header.magic = SnapshotMagic;
+	header.version = 1;
+	header.deviceCount = out.size();
+	header.namesOffset = sizeof(SnapshotHeader) + out.size() * sizeof(SnapshotEntry);
+	header.namesSize = nameBlob.size();
+
+	std::string tmp = path + ".tmp";
+	{
+		std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) return false;
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(out.data()), out.size() * sizeof(SnapshotEntry));
+		file.write(nameBlob.data(), nameBlob.size());
+		if (!file) return false;
+	}
+
+	// Everything still only in the old mapping has been copied into tmp, so
+	// tmp replaces it as soon as it maps; until then the old one stays.
+	if (!mapSnapshot(tmp)) {
+		std::remove(tmp.c_str());
+		return false;
+	}
+	shadowed = devices.size();
+#ifdef _WIN32
+	// Replacing works now that the old mapping is released.
+	if (!MoveFileExA(tmp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) return false;
+#else
+	if (std::rename(tmp.c_str(), path.c_str()) != 0) return false;
+#endif
+
+	for (auto& entry : devices) {
+		persisted[entry.second.get()] = entry.second->isOn();
+	}
+	if (journal.is_open()) {
+		journal.close();
+		journal.open(journalPath, std::ios::binary | std::ios::trunc);
+	}
+	return true;
+}
+
+// Visits live devices merged with snapshot-only ones in name order, without
+// materializing anything: fn(name, type, on, lastChange).
+template<class Fn>
+inline void CentralController::forEachDevice(Fn fn) const {
+	auto it = devices.begin();
+	size_t i = 0;
+	while (it != devices.end() || i < entryCount) {
+		int cmp = it == devices.end() ? 1 : i == entryCount ? -1 : std::string_view(it->first).compare(entryName(entries[i]));
+		if (cmp <= 0) {
+			const Device& dev = *it->second;
+			uint64_t changed = dev.lastChange();	// before isOn(), see Device::lastChange
+			fn(std::string_view(it->first), dev.getType(), dev.isOn(), changed);
+			++it;
+			if (cmp == 0) i++;
+		}
+		else {
+			fn(entryName(entries[i]), entries[i].type, entries[i].on != 0, snapshotSequence);
+			i++;
+		}
+	}
+}
+
+// Maps and validates path, and only then swaps it in for the current mapping;
+// on failure the current snapshot stays as it was.
+inline bool CentralController::mapSnapshot(const std::string& path) {
+	MappedFile file;
+	if (!file.open(path)) return false;
+	SnapshotHeader header;
+	if (file.size() < sizeof(header)) return false;
+	std::memcpy(&header, file.data(), sizeof(header));
+	if (header.magic != SnapshotMagic || header.version != 1 ||
+		header.deviceCount > (file.size() - sizeof(header)) / sizeof(SnapshotEntry) ||
+		header.namesOffset < sizeof(header) + header.deviceCount * sizeof(SnapshotEntry) ||
+		header.namesOffset > file.size() || header.namesSize > file.size() - header.namesOffset) {
+		return false;
+	}
+	const SnapshotEntry* fileEntries = reinterpret_cast<const SnapshotEntry*>(file.data() + sizeof(header));
+	for (uint64_t i = 0; i < header.deviceCount; i++) {
+		if (uint64_t(fileEntries[i].nameOffset) + fileEntries[i].nameLength > header.namesSize) return false;
+	}
+
+	snapshot.swap(file);
+	entries = fileEntries;
+	names = snapshot.data() + header.namesOffset;
+	entryCount = static_cast<size_t>(header.deviceCount);
+	return true;
+}
+
+inline void CentralController::closeSnapshot() {
+	snapshot.close();
+	entries = nullptr;
+	names = nullptr;
+	entryCount = 0;
+	shadowed = 0;
+}
+
+// Replaces the registry with the snapshot at snapshotPath plus the deltas
+// journaled after it. Only the journaled devices are allocated up front.
+inline bool CentralController::coldStart(const std::string& snapshotPath, const std::string& journalPath) {
+	journal.close();
+	devices.clear();
+	persisted.clear();
+	closeSnapshot();
+
+	bool mapped = mapSnapshot(snapshotPath);
+	snapshotSequence = Device::nextSequence();
+	replayJournal(journalPath);
+	enableJournal(journalPath);
+	return mapped;
+}
+
+inline void CentralController::enableJournal(const std::string& path) {
+	journal.close();
+	journalPath = path;
+	journal.open(path, std::ios::binary | std::ios::app);
+}
+
+inline void CentralController::writeJournal(DeviceJournalRecord::Kind kind, const std::string& name, const Device& dev) {
+	if (!journal.is_open()) return;
+	DeviceJournalRecord record;
+	record.kind = kind;
+	record.type = dev.getType();
+	record.on = dev.isOn() ? 1 : 0;
+	record.reserved = 0;
+	record.nameLength = static_cast<uint32_t>(name.size());
+	journal.write(reinterpret_cast<const char*>(&record), sizeof(record));
+	journal.write(name.data(), name.size());
+}
+
+inline void CentralController::replayJournal(const std::string& path) {
+	std::ifstream in(path, std::ios::binary | std::ios::ate);
+	if (!in.is_open()) return;
+	std::vector<char> data(static_cast<size_t>(in.tellg()));
+	in.seekg(0);
+	in.read(data.data(), data.size());
+
+	size_t pos = 0;
+	while (pos + sizeof(DeviceJournalRecord) <= data.size()) {
+		DeviceJournalRecord record;
+		std::memcpy(&record, data.data() + pos, sizeof(record));
+		pos += sizeof(record);
+		if (pos + record.nameLength > data.size()) break;
+		std::string name(data.data() + pos, record.nameLength);
+		pos += record.nameLength;
+
+		std::shared_ptr<Device> dev;
+		if (record.kind == DeviceJournalRecord::Register) {
+			dev = DeviceFactory::createDevice(record.type);
+			if (!dev) continue;
+			auto it = devices.find(name);
+			if (it != devices.end()) {
+				persisted.erase(it->second.get());
+				it->second = dev;
+			}
+			else {
+				if (entries && findEntry(name)) shadowed++;
+				devices.emplace(name, dev);
+			}
+		}
+		else {
+			dev = getDevice(name);
+			if (!dev) continue;
+		}
+		if (record.on) dev->turnOn();
+		else dev->turnOff();
+		persisted[dev.get()] = record.on != 0;
+	}
+}
+
+// Appends a State record for every live device whose on/off state differs
+// from what the snapshot and journal already hold.
+inline size_t CentralController::journalChanges() {
+	size_t written = 0;
+	for (auto& entry : devices) {
+		Device& dev = *entry.second;
+		bool on = dev.isOn();
+		auto p = persisted.find(&dev);
+		if (p != persisted.end() && p->second == on) continue;
+		persisted[&dev] = on;
+		writeJournal(DeviceJournalRecord::State, entry.first, dev);
+		written++;
+	}
+	if (journal.is_open()) journal.flush();
+	return written;
+}
+
+// Serializes every device that changed after sinceSequence (all of them
+// for 0) into out, reusing its capacity. Returns the sequence to pass next
+// time. May run while devices are being switched: a change that took a
+// sequence up to the returned one is already visible (Device::setState), so
+// a device changed during the export may be sent twice, but never missed.
+inline uint64_t CentralController::exportTelemetry(std::vector<char>& out, uint64_t sinceSequence) {
+	uint64_t sequence = Device::currentSequence();
+	telemetryRows.clear();
+	size_t namesSize = 0;
+	forEachDevice([&](std::string_view name, DeviceType type, bool on, uint64_t changed) {
+		if (changed <= sinceSequence) return;
+		telemetryRows.push_back({ name, type, on });
+		namesSize += name.size();
+	});
+
+	size_t count = telemetryRows.size();
+	TelemetryHeader header;
+	header.magic = TelemetryMagic;
+	header.version = 2;
+	header.epoch = Device::sequenceEpoch();
+	header.sinceSequence = sinceSequence;
+	header.sequence = sequence;
+	header.deviceCount = count;
+	header.namesSize = namesSize;
+
+	out.resize(sizeof(header) + count * (sizeof(uint32_t) + 2) + namesSize);
+	char* base = out.data();
+	std::memcpy(base, &header, sizeof(header));
+	char* nameEnd = base + sizeof(header);
+	char* types = nameEnd + count * sizeof(uint32_t);
+	char* states = types + count;
+	char* names = states + count;
+
+	uint32_t offset = 0;
+	for (size_t i = 0; i < count; i++) {
+		const TelemetryRow& row = telemetryRows[i];
+		std::memcpy(names + offset, row.name.data(), row.name.size());
+		offset += static_cast<uint32_t>(row.name.size());
+		std::memcpy(nameEnd + i * sizeof(uint32_t), &offset, sizeof(offset));
+		types[i] = static_cast<char>(row.type);
+		states[i] = row.on ? 1 : 0;
+	}
+	return sequence;
+}
+
+#endif
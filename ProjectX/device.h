@@ -1,46 +1,101 @@
-
-#ifndef DEVICE_H
-#define DEVICE_H
-
-#include <iostream>
-using std::string;
-
-class Device {
-public:
-	virtual void turnOn() = 0;
-	virtual void turnOff() = 0;
-	virtual string getStatus() = 0;
-	virtual ~Device() {}
-};
-
-class Light : public Device {
-private:
-	bool status = false;
-public:
-	void turnOn() override;
-	void turnOff() override;
-	string getStatus() override;
-
-};
-
-class Fan : public Device {
-private:
-	bool status = false;
-public:
-	void turnOn() override;
-	void turnOff() override;
-	string getStatus() override;
-
-};
-
-class AirConditioner : Device {
-private:
-	bool status = false;
-public:
-	void turnOn() override;
-	void turnOff() override;
-	string getStatus() override;
-
-};
-
+
+#ifndef DEVICE_H
+#define DEVICE_H
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <atomic>
+#include <cstdint>
+using std::string;
+
+enum class DeviceType : uint8_t { Light, Fan, AirConditioner };
+
+struct DeviceStatus {
+	DeviceType type;
+	bool on;
+	uint64_t changed;	// sequence number of the last state change
+};
+
+class Device {
+public:
+	Device() : changed(nextSequence()) {}
+	virtual void turnOn() = 0;
+	virtual void turnOff() = 0;
+	// Points at static text, so polling status never allocates.
+	virtual std::string_view statusText() const = 0;
+	virtual DeviceType getType() const = 0;
+	virtual bool isOn() const = 0;
+	virtual ~Device() {}
+
+	string getStatus() const { return string(statusText()); }
+	DeviceStatus status() const {
+		uint64_t sequence = lastChange();
+		return { getType(), isOn(), sequence };
+	}
+	// Read this before isOn(): the state seen afterwards is at least as new.
+	// Waits out an on/off change that is in progress on another thread.
+	uint64_t lastChange() const;
+
+	// Every creation and on/off change takes the next number from one global
+	// counter; exports remember the last number they saw to send deltas.
+	// Sequences restart with the process; sequenceEpoch() tells runs apart.
+	static uint64_t nextSequence();
+	static uint64_t currentSequence();
+	static uint64_t sequenceEpoch();
+
+protected:
+	// One writer per device at a time (see CommandPipeline). The device is
+	// marked Changing before it takes its sequence, and the state is stored
+	// before the sequence is published, so an export that has read
+	// currentSequence() can never see an older change than that.
+	void setState(std::atomic<bool>& state, bool on) {
+		if (state.load(std::memory_order_relaxed) == on) return;
+		changed.store(Changing, std::memory_order_seq_cst);
+		uint64_t sequence = nextSequence();
+		state.store(on, std::memory_order_relaxed);
+		changed.store(sequence, std::memory_order_release);
+	}
+	// A device rebuilt from a snapshot keeps the sequence it was exported with.
+	void restoreChange(uint64_t sequence) { changed.store(sequence, std::memory_order_release); }
+
+private:
+	friend class CentralController;
+	static constexpr uint64_t Changing = UINT64_MAX;
+	std::atomic<uint64_t> changed;
+};
+
+class Light : public Device {
+private:
+	std::atomic<bool> status{ false };
+public:
+	void turnOn() override;
+	void turnOff() override;
+	std::string_view statusText() const override;
+	DeviceType getType() const override { return DeviceType::Light; }
+	bool isOn() const override { return status; }
+};
+
+class Fan : public Device {
+private:
+	std::atomic<bool> status{ false };
+public:
+	void turnOn() override;
+	void turnOff() override;
+	std::string_view statusText() const override;
+	DeviceType getType() const override { return DeviceType::Fan; }
+	bool isOn() const override { return status; }
+};
+
+class AirConditioner : public Device {
+private:
+	std::atomic<bool> status{ false };
+public:
+	void turnOn() override;
+	void turnOff() override;
+	std::string_view statusText() const override;
+	DeviceType getType() const override { return DeviceType::AirConditioner; }
+	bool isOn() const override { return status; }
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,123 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <cstddef>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Read-only memory mapping of a whole file.
+class MappedFile {
+public:
+	MappedFile() {}
+	~MappedFile() { close(); }
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::string& path);
+	void close();
+	void swap(MappedFile& other);
+
+	const char* data() const { return base; }
+	size_t size() const { return length; }
+	bool isOpen() const { return base != nullptr; }
+
+private:
+	const char* base = nullptr;
+	size_t length = 0;
+#ifdef _WIN32
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+#endif
+};
+
+#ifdef _WIN32
+
+inline bool MappedFile::open(const std::string& path) {
+	close();
+	// FILE_SHARE_DELETE lets the file be renamed while it is mapped.
+	file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+		close();
+		return false;
+	}
+	mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping) {
+		close();
+		return false;
+	}
+	base = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (!base) {
+		close();
+		return false;
+	}
+	length = static_cast<size_t>(fileSize.QuadPart);
+	return true;
+}
+
+inline void MappedFile::close() {
+	if (base) UnmapViewOfFile(base);
+	if (mapping) CloseHandle(mapping);
+	if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+	base = nullptr;
+	mapping = nullptr;
+	file = INVALID_HANDLE_VALUE;
+	length = 0;
+}
+
+inline void MappedFile::swap(MappedFile& other) {
+	std::swap(base, other.base);
+	std::swap(length, other.length);
+	std::swap(file, other.file);
+	std::swap(mapping, other.mapping);
+}
+
+#else
+
+inline bool MappedFile::open(const std::string& path) {
+	close();
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		::close(fd);
+		return false;
+	}
+	void* addr = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (addr == MAP_FAILED) return false;
+
+	base = static_cast<const char*>(addr);
+	length = static_cast<size_t>(st.st_size);
+	return true;
+}
+
+inline void MappedFile::close() {
+	if (base) munmap(const_cast<char*>(base), length);
+	base = nullptr;
+	length = 0;
+}
+
+inline void MappedFile::swap(MappedFile& other) {
+	std::swap(base, other.base);
+	std::swap(length, other.length);
+}
+
+#endif
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef MPSCQUEUE_H
+#define MPSCQUEUE_H
+
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+
+// Bounded lock-free queue for many producers and one consumer (Vyukov's
+// sequence-numbered ring; the single consumer needs no CAS).
+template<class T>
+class MpscQueue {
+public:
+	explicit MpscQueue(size_t capacity) : mask(roundUp(capacity) - 1), cells(mask + 1) {
+		for (size_t i = 0; i <= mask; i++) {
+			cells[i].seq.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	bool tryPush(const T& value) {
+		size_t pos = enqueuePos.load(std::memory_order_relaxed);
+		Cell* cell;
+		while (true) {
+			cell = &cells[pos & mask];
+			size_t seq = cell->seq.load(std::memory_order_acquire);
+			intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+			if (dif == 0) {
+				if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+			}
+			else if (dif < 0) {
+				return false;
+			}
+			else {
+				pos = enqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+		cell->value = value;
+		cell->seq.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool tryPop(T& value) {
+		Cell& cell = cells[dequeuePos & mask];
+		if (cell.seq.load(std::memory_order_acquire) != dequeuePos + 1) return false;
+		value = cell.value;
+		cell.seq.store(dequeuePos + mask + 1, std::memory_order_release);
+		dequeuePos++;
+		return true;
+	}
+
+	bool empty() const {
+		return cells[dequeuePos & mask].seq.load(std::memory_order_acquire) != dequeuePos + 1;
+	}
+
+private:
+	struct Cell {
+		std::atomic<size_t> seq;
+		T value;
+	};
+
+	static size_t roundUp(size_t n) {
+		size_t c = 2;
+		while (c < n) c <<= 1;
+		return c;
+	}
+
+	const size_t mask;
+	std::vector<Cell> cells;
+	alignas(64) std::atomic<size_t> enqueuePos{ 0 };
+	alignas(64) size_t dequeuePos = 0;
+};
+
+// Lets the single consumer of lock-free queues block when they are empty
+// without producers taking a lock on every push. Producers call ring() after
+// publishing; the consumer calls wait(idle) once it has found nothing to do.
+class Doorbell {
+public:
+	// Only an idle consumer needs a nudge; a busy one will see the work.
+	// Taking the mutex orders the nudge after the consumer's last look at its
+	// queues, so it cannot fall between that look and the wait.
+	void ring() {
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (sleeping.load(std::memory_order_seq_cst)) wake();
+	}
+
+	// Unconditional ring(), for state the idle check reads that is not a
+	// queue push, such as a stop flag.
+	void wake() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+		}
+		bell.notify_one();
+	}
+
+	// Blocks unless idle() turns false once the consumer is marked sleeping.
+	// May return spuriously; the caller re-checks its queues anyway.
+	template<class Idle>
+	void wait(Idle idle) {
+		std::unique_lock<std::mutex> lock(mutex);
+		sleeping.store(true, std::memory_order_seq_cst);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (idle()) bell.wait(lock);
+		sleeping.store(false, std::memory_order_relaxed);
+	}
+
+private:
+	std::mutex mutex;
+	std::condition_variable bell;
+	std::atomic<bool> sleeping{ false };
+};
+
+#endif
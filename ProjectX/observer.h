@@ -0,0 +1,479 @@
+#ifndef OBSERVER_H
+#define OBSERVER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include <string_view>
+#include "mpscqueue.h"
+
+enum class EventType : uint8_t { Intrusion, Motion, DoorOpened, DoorClosed, Temperature };
+
+struct Event {
+	EventType type = EventType::Intrusion;
+	uint32_t source = 0;
+	uint32_t count = 1;	// > 1 when duplicate events were coalesced
+	int64_t value = 0;
+	int64_t timestamp = 0;	// steady_clock nanoseconds of the latest occurrence
+};
+
+inline const char* eventText(EventType type) {
+	switch (type) {
+	case EventType::Intrusion: return "Intruders!!! \n";
+	case EventType::Motion: return "Motion detected";
+	case EventType::DoorOpened: return "Door opened";
+	case EventType::DoorClosed: return "Door closed";
+	case EventType::Temperature: return "Temperature changed";
+	default: return "Unknown event";
+	}
+}
+
+class Observer {
+public:
+	virtual void update(const std::string& event) = 0;
+
+	// Batched delivery from an EventBus. Observers that care about throughput
+	// override this; the default forwards each event to update().
+	virtual void onEvents(const Event* events, size_t count) {
+		for (size_t i = 0; i < count; i++) {
+			update(eventText(events[i].type));
+		}
+	}
+	virtual ~Observer() {}
+};
+
+enum class BackPressure { DropNewest, Block };
+
+// Asynchronous delivery for Subject. Every observer gets one preallocated
+// mailbox (a bounded multi-producer queue) that all subjects publish into, so
+// publish() is a couple of atomic ops and only touches a mutex to wake an idle
+// delivery thread. Observers are spread round-robin over the delivery threads;
+// one thread drains a mailbox, which keeps each observer's delivery serial and
+// in order per subject.
+class EventBus {
+public:
+	struct Subscription;
+
+	EventBus(size_t threads, size_t queueCapacity = 1024, size_t batchSize = 64,
+		BackPressure policy = BackPressure::DropNewest);
+	~EventBus();
+
+	// Returns the observer's mailbox, creating it on first use. Safe to call
+	// from any thread, but it locks and allocates, so resolve mailboxes up front
+	// rather than on the publish path.
+	Subscription* subscribe(Observer* observer);
+	bool publish(Subscription& sub, const Event& event);
+
+	uint64_t dropped() const;
+
+private:
+	struct Worker {
+		std::thread thread;
+		Doorbell doorbell;
+		std::mutex mutex;	// guards subscriptions
+		std::atomic<uint64_t> version{ 0 };
+		std::vector<Subscription*> subscriptions;
+	};
+
+	const size_t capacity;
+	const size_t batchSize;
+	const BackPressure policy;
+	std::atomic<bool> stopping{ false };
+	mutable std::mutex subscribeMutex;
+	std::unordered_map<Observer*, std::unique_ptr<Subscription>> subscriptions;
+	size_t nextWorker = 0;
+	std::vector<std::unique_ptr<Worker>> workers;
+
+	void run(Worker& worker);
+	size_t drain(Subscription& sub, std::vector<Event>& batch);
+};
+
+struct EventBus::Subscription {
+	explicit Subscription(size_t capacity) : queue(capacity) {}
+	Observer* observer = nullptr;
+	Worker* worker = nullptr;
+	MpscQueue<Event> queue;
+	std::atomic<uint64_t> dropped{ 0 };
+};
+
+inline EventBus::EventBus(size_t threads, size_t queueCapacity, size_t batch, BackPressure p)
+	: capacity(queueCapacity ? queueCapacity : 1), batchSize(batch ? batch : 1), policy(p) {
+	for (size_t i = 0; i < (threads ? threads : 1); i++) {
+		workers.push_back(std::make_unique<Worker>());
+	}
+	for (auto& worker : workers) {
+		Worker* w = worker.get();
+		w->thread = std::thread([this, w] { run(*w); });
+	}
+}
+
+inline EventBus::~EventBus() {
+	stopping = true;
+	for (auto& worker : workers) {
+		worker->doorbell.wake();
+		worker->thread.join();
+	}
+}
+
+inline EventBus::Subscription* EventBus::subscribe(Observer* observer) {
+	Subscription* raw;
+	{
+		std::lock_guard<std::mutex> lock(subscribeMutex);
+		std::unique_ptr<Subscription>& sub = subscriptions[observer];
+		if (sub) return sub.get();
+		sub = std::make_unique<Subscription>(capacity);
+		sub->observer = observer;
+		sub->worker = workers[nextWorker++ % workers.size()].get();
+		raw = sub.get();
+	}
+	{
+		std::lock_guard<std::mutex> lock(raw->worker->mutex);
+		raw->worker->subscriptions.push_back(raw);
+		raw->worker->version++;
+	}
+	return raw;
+}
+
+inline bool EventBus::publish(Subscription& sub, const Event& event) {
+	while (!sub.queue.tryPush(event)) {
+		if (policy == BackPressure::DropNewest) {
+			sub.dropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		std::this_thread::yield();
+	}
+	sub.worker->doorbell.ring();
+	return true;
+}
+
+inline uint64_t EventBus::dropped() const {
+	std::lock_guard<std::mutex> lock(subscribeMutex);
+	uint64_t total = 0;
+	for (auto& entry : subscriptions) {
+		total += entry.second->dropped.load(std::memory_order_relaxed);
+	}
+	return total;
+}
+
+inline size_t EventBus::drain(Subscription& sub, std::vector<Event>& batch) {
+	// Coalesce runs of identical events (same kind, source and value) into one
+	// record carrying the repeat count and the latest timestamp.
+	batch.clear();
+	size_t n = 0;
+	Event e;
+	while (n < batchSize && sub.queue.tryPop(e)) {
+		n++;
+		if (!batch.empty()) {
+			Event& last = batch.back();
+			if (last.type == e.type && last.source == e.source && last.value == e.value) {
+				last.count += e.count;
+				last.timestamp = e.timestamp;
+				continue;
+			}
+		}
+		batch.push_back(e);
+	}
+	if (n) sub.observer->onEvents(batch.data(), batch.size());
+	return n;
+}
+
+inline void EventBus::run(Worker& worker) {
+	std::vector<Event> batch;
+	batch.reserve(batchSize);
+	std::vector<Subscription*> subs;
+	uint64_t seen = ~uint64_t(0);
+
+	while (true) {
+		if (worker.version.load() != seen) {
+			std::lock_guard<std::mutex> lock(worker.mutex);
+			subs = worker.subscriptions;
+			seen = worker.version.load();
+		}
+
+		// Read the stop flag before draining so events published before shutdown
+		// always get one last pass.
+		bool stop = stopping.load();
+		size_t delivered = 0;
+		for (Subscription* sub : subs) {
+			delivered += drain(*sub, batch);
+		}
+		if (delivered) continue;
+		if (stop) return;
+
+		worker.doorbell.wait([&] {
+			for (Subscription* sub : subs) {
+				if (!sub->queue.empty()) return false;
+			}
+			return !stopping && worker.version.load() == seen;
+		});
+	}
+}
+
+// Hierarchical topic index, e.g. "home/floor1/door/front". Patterns may use
+// "*" for exactly one level and a trailing "#" for any number of levels, so a
+// publish visits only the trie branches that can match. The trie is immutable
+// once published: writers copy the path they change and swap the root, and
+// readers walk whichever snapshot they loaded (RCU style). An observer that
+// unsubscribes may still see events from publishes already in flight. An
+// observer whose patterns overlap still gets each event once.
+//
+// With a bus, subscribe() resolves the observer's mailbox once and stores it in
+// the trie, so publish() neither locks nor allocates; without one, publish()
+// delivers synchronously on the caller's thread.
+class TopicIndex {
+public:
+	using SubscriptionId = uint64_t;
+
+	explicit TopicIndex(EventBus* eventBus = nullptr) : bus(eventBus) {}
+
+	SubscriptionId subscribe(const std::string& pattern, Observer* observer);
+	bool unsubscribe(SubscriptionId id);
+
+	template<class F>
+	void match(std::string_view topic, F&& deliver) const;
+	void publish(std::string_view topic, const Event& event) const;
+
+private:
+	struct Entry {
+		SubscriptionId id;
+		Observer* observer;
+		EventBus::Subscription* mailbox;	// nullptr without a bus
+	};
+	struct Node {
+		std::map<std::string, std::shared_ptr<const Node>, std::less<>> children;
+		std::shared_ptr<const Node> anyOne;	// "*"
+		std::vector<Entry> here;			// pattern ends at this node
+		std::vector<Entry> below;			// "#": this node and everything under it
+	};
+
+	static constexpr size_t InlineMatches = 16;
+
+	EventBus* const bus;
+	std::shared_ptr<const Node> root = std::make_shared<Node>();
+	std::mutex writeMutex;
+	std::unordered_map<SubscriptionId, std::pair<std::string, Observer*>> patterns;
+	SubscriptionId nextId = 1;
+
+	static std::string_view segment(std::string_view topic, size_t pos, size_t& next);
+	static std::shared_ptr<const Node> insert(const Node* node, std::string_view pattern, size_t pos, Entry entry);
+	static std::shared_ptr<const Node> erase(const Node* node, std::string_view pattern, size_t pos, SubscriptionId id);
+	template<class F>
+	static void walk(const Node* node, std::string_view topic, size_t pos, F& deliver);
+	template<class F>
+	void forEachObserver(std::string_view topic, F&& deliver) const;
+};
+
+inline std::string_view TopicIndex::segment(std::string_view topic, size_t pos, size_t& next) {
+	size_t slash = topic.find('/', pos);
+	if (slash == std::string_view::npos) {
+		next = std::string_view::npos;
+		return topic.substr(pos);
+	}
+	next = slash + 1;
+	return topic.substr(pos, slash - pos);
+}
+
+inline TopicIndex::SubscriptionId TopicIndex::subscribe(const std::string& pattern, Observer* observer) {
+	EventBus::Subscription* mailbox = bus ? bus->subscribe(observer) : nullptr;
+	std::lock_guard<std::mutex> lock(writeMutex);
+	SubscriptionId id = nextId++;
+	std::shared_ptr<const Node> current = std::atomic_load(&root);
+	std::atomic_store(&root, insert(current.get(), pattern, 0, Entry{ id, observer, mailbox }));
+	patterns.emplace(id, std::make_pair(pattern, observer));
+	return id;
+}
+
+inline bool TopicIndex::unsubscribe(SubscriptionId id) {
+	std::lock_guard<std::mutex> lock(writeMutex);
+	auto it = patterns.find(id);
+	if (it == patterns.end()) return false;
+	std::shared_ptr<const Node> current = std::atomic_load(&root);
+	std::shared_ptr<const Node> updated = erase(current.get(), it->second.first, 0, id);
+	std::atomic_store(&root, updated ? updated : std::make_shared<const Node>());
+	patterns.erase(it);
+	return true;
+}
+
+inline std::shared_ptr<const TopicIndex::Node> TopicIndex::insert(const Node* node, std::string_view pattern,
+	size_t pos, Entry entry) {
+	auto copy = node ? std::make_shared<Node>(*node) : std::make_shared<Node>();
+	if (pos == std::string_view::npos) {
+		copy->here.push_back(entry);
+		return copy;
+	}
+	size_t next;
+	std::string_view seg = segment(pattern, pos, next);
+	if (seg == "#") {
+		copy->below.push_back(entry);
+	}
+	else if (seg == "*") {
+		copy->anyOne = insert(copy->anyOne.get(), pattern, next, entry);
+	}
+	else {
+		auto child = copy->children.find(seg);
+		const Node* existing = child == copy->children.end() ? nullptr : child->second.get();
+		copy->children[std::string(seg)] = insert(existing, pattern, next, entry);
+	}
+	return copy;
+}
+
+// Returns the rewritten node, or nullptr when it no longer holds anything.
+inline std::shared_ptr<const TopicIndex::Node> TopicIndex::erase(const Node* node, std::string_view pattern,
+	size_t pos, SubscriptionId id) {
+	if (!node) return nullptr;
+	auto copy = std::make_shared<Node>(*node);
+	auto without = [id](std::vector<Entry>& entries) {
+		entries.erase(std::remove_if(entries.begin(), entries.end(),
+			[id](const Entry& e) { return e.id == id; }), entries.end());
+	};
+
+	if (pos == std::string_view::npos) {
+		without(copy->here);
+	}
+	else {
+		size_t next;
+		std::string_view seg = segment(pattern, pos, next);
+		if (seg == "#") {
+			without(copy->below);
+		}
+		else if (seg == "*") {
+			copy->anyOne = erase(copy->anyOne.get(), pattern, next, id);
+		}
+		else {
+			auto child = copy->children.find(seg);
+			if (child != copy->children.end()) {
+				auto updated = erase(child->second.get(), pattern, next, id);
+				if (updated) child->second = updated;
+				else copy->children.erase(child);
+			}
+		}
+	}
+
+	if (copy->here.empty() && copy->below.empty() && !copy->anyOne && copy->children.empty()) {
+		return nullptr;
+	}
+	return copy;
+}
+
+// Calls deliver(entry) once per observer that matches topic, however many of
+// its patterns do. Matches are collected on the stack (the heap is only used
+// past InlineMatches) and sorted so duplicates end up next to each other.
+template<class F>
+void TopicIndex::forEachObserver(std::string_view topic, F&& deliver) const {
+	std::shared_ptr<const Node> snapshot = std::atomic_load(&root);
+	const Entry* inlineMatches[InlineMatches];
+	std::vector<const Entry*> spilled;
+	size_t count = 0;
+	auto collect = [&](const Entry& e) {
+		if (count < InlineMatches) {
+			inlineMatches[count] = &e;
+		}
+		else {
+			if (spilled.empty()) spilled.assign(inlineMatches, inlineMatches + InlineMatches);
+			spilled.push_back(&e);
+		}
+		count++;
+	};
+	walk(snapshot.get(), topic, 0, collect);
+
+	const Entry** matches = count <= InlineMatches ? inlineMatches : spilled.data();
+	std::sort(matches, matches + count, [](const Entry* a, const Entry* b) {
+		return std::less<Observer*>()(a->observer, b->observer);
+	});
+	for (size_t i = 0; i < count; i++) {
+		if (i > 0 && matches[i]->observer == matches[i - 1]->observer) continue;
+		deliver(*matches[i]);
+	}
+}
+
+template<class F>
+void TopicIndex::match(std::string_view topic, F&& deliver) const {
+	forEachObserver(topic, [&deliver](const Entry& e) { deliver(e.observer); });
+}
+
+inline void TopicIndex::publish(std::string_view topic, const Event& event) const {
+	forEachObserver(topic, [this, &event](const Entry& e) {
+		if (e.mailbox) bus->publish(*e.mailbox, event);
+		else e.observer->onEvents(&event, 1);
+	});
+}
+
+template<class F>
+void TopicIndex::walk(const Node* node, std::string_view topic, size_t pos, F& deliver) {
+	for (const Entry& e : node->below) deliver(e);
+	if (pos == std::string_view::npos) {
+		for (const Entry& e : node->here) deliver(e);
+		return;
+	}
+	size_t next;
+	std::string_view seg = segment(topic, pos, next);
+	auto child = node->children.find(seg);
+	if (child != node->children.end()) walk(child->second.get(), topic, next, deliver);
+	if (node->anyOne) walk(node->anyOne.get(), topic, next, deliver);
+}
+
+class Subject {
+	std::vector<Observer*> observers;
+	std::vector<EventBus::Subscription*> subscriptions;
+	EventBus* bus = nullptr;
+	TopicIndex* topics = nullptr;
+	std::string topic;
+public:
+	void addObserver(Observer* observer) {
+		observers.push_back(observer);
+		if (bus) subscriptions.push_back(bus->subscribe(observer));
+	}
+
+	// Switches this subject to asynchronous delivery. Observers see its events
+	// in the order notify() was called, so call it from one thread at a time.
+	void attachBus(EventBus& eventBus) {
+		bus = &eventBus;
+		subscriptions.clear();
+		for (Observer* observer : observers) {
+			subscriptions.push_back(bus->subscribe(observer));
+		}
+	}
+
+	// Publishes under a topic: notify() then reaches every observer whose
+	// pattern in the index matches, instead of the addObserver() list. Delivery
+	// goes through the index's bus, if it has one.
+	void attachTopics(TopicIndex& index, std::string subjectTopic) {
+		topics = &index;
+		topic = std::move(subjectTopic);
+	}
+
+	void notifyAllObservers(const std::string& event) {
+		for (Observer* observer : observers) {
+			observer->update(event);
+		}
+	}
+
+	void notify(Event event) {
+		event.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+		if (topics) {
+			topics->publish(topic, event);
+			return;
+		}
+		if (!bus) {
+			for (Observer* observer : observers) {
+				observer->onEvents(&event, 1);
+			}
+			return;
+		}
+		for (EventBus::Subscription* sub : subscriptions) {
+			bus->publish(*sub, event);
+		}
+	}
+};
+
+#endif
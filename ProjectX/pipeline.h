@@ -0,0 +1,185 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <future>
+#include <functional>
+#include <cstdint>
+#include <algorithm>
+#include "device.h"
+#include "command.h"
+#include "mpscqueue.h"
+
+// Multi-threaded front end for device commands. Each device is owned by one
+// shard thread (picked by hashing its address), so device state is only ever
+// touched by that thread and needs no locking. A shard drains its queue in
+// batches and applies only the last command per device in each batch.
+class CommandPipeline {
+public:
+	CommandPipeline(size_t shards = std::thread::hardware_concurrency(), size_t queueCapacity = 1 << 16,
+		size_t batchSize = 1024);
+	~CommandPipeline();
+
+	// Fire-and-forget; no allocation on this path.
+	void post(Device* device, CommandOp op);
+	// Resolves once the shard has processed the command (or coalesced it away).
+	std::future<void> submit(Device* device, CommandOp op);
+
+	uint64_t processed() const;
+	uint64_t coalesced() const;
+
+private:
+	struct Item {
+		Device* device = nullptr;
+		CommandOp op = CommandOp::TurnOn;
+		std::promise<void>* done = nullptr;
+	};
+
+	struct Shard {
+		explicit Shard(size_t capacity) : queue(capacity) {}
+		MpscQueue<Item> queue;
+		std::thread thread;
+		Doorbell doorbell;
+		std::atomic<uint64_t> processed{ 0 };
+		std::atomic<uint64_t> coalesced{ 0 };
+	};
+
+	const size_t batchSize;
+	std::atomic<bool> stopping{ false };
+	std::vector<std::unique_ptr<Shard>> shards;
+
+	// std::hash of a pointer is the address itself, whose low bits are the
+	// same for every aligned allocation; mix it before picking a shard or slot.
+	static size_t mix(const Device* device) {
+		return static_cast<size_t>(((reinterpret_cast<uintptr_t>(device) >> 4) * 0x9E3779B97F4A7C15ull) >> 32);
+	}
+	Shard& shardFor(Device* device) {
+		return *shards[mix(device) % shards.size()];
+	}
+	void enqueue(const Item& item);
+	void run(Shard& shard);
+};
+
+inline CommandPipeline::CommandPipeline(size_t shardCount, size_t queueCapacity, size_t batch)
+	: batchSize(batch ? batch : 1) {
+	for (size_t i = 0; i < (shardCount ? shardCount : 1); i++) {
+		shards.push_back(std::make_unique<Shard>(queueCapacity));
+	}
+	for (auto& shard : shards) {
+		Shard* s = shard.get();
+		s->thread = std::thread([this, s] { run(*s); });
+	}
+}
+
+inline CommandPipeline::~CommandPipeline() {
+	stopping = true;
+	for (auto& shard : shards) {
+		shard->doorbell.wake();
+		shard->thread.join();
+	}
+}
+
+inline void CommandPipeline::post(Device* device, CommandOp op) {
+	Item item;
+	item.device = device;
+	item.op = op;
+	enqueue(item);
+}
+
+inline std::future<void> CommandPipeline::submit(Device* device, CommandOp op) {
+	Item item;
+	item.device = device;
+	item.op = op;
+	item.done = new std::promise<void>();
+	std::future<void> result = item.done->get_future();
+	enqueue(item);
+	return result;
+}
+
+inline void CommandPipeline::enqueue(const Item& item) {
+	Shard& shard = shardFor(item.device);
+	while (!shard.queue.tryPush(item)) {
+		// Queue full: the shard is behind, so give it the CPU.
+		std::this_thread::yield();
+	}
+	shard.doorbell.ring();
+}
+
+inline uint64_t CommandPipeline::processed() const {
+	uint64_t total = 0;
+	for (auto& shard : shards) total += shard->processed.load(std::memory_order_relaxed);
+	return total;
+}
+
+inline uint64_t CommandPipeline::coalesced() const {
+	uint64_t total = 0;
+	for (auto& shard : shards) total += shard->coalesced.load(std::memory_order_relaxed);
+	return total;
+}
+
+inline void CommandPipeline::run(Shard& shard) {
+	std::vector<Item> batch;
+	batch.reserve(batchSize);
+
+	// Open-addressed "seen this batch" set; generation stamps avoid clearing it.
+	size_t tableSize = 2;
+	while (tableSize < batchSize * 2) tableSize <<= 1;
+	std::vector<Device*> seenDevice(tableSize, nullptr);
+	std::vector<uint32_t> seenGen(tableSize, 0);
+	uint32_t gen = 0;
+
+	while (true) {
+		bool stop = stopping.load();
+		batch.clear();
+		Item item;
+		while (batch.size() < batchSize && shard.queue.tryPop(item)) {
+			batch.push_back(item);
+		}
+
+		if (!batch.empty()) {
+			if (++gen == 0) {
+				std::fill(seenGen.begin(), seenGen.end(), 0);
+				gen = 1;
+			}
+			uint64_t skipped = 0;
+			// Walk backwards so the first time we meet a device is its last write.
+			for (size_t i = batch.size(); i-- > 0;) {
+				Device* device = batch[i].device;
+				size_t h = mix(device) & (tableSize - 1);
+				bool seen = false;
+				while (seenGen[h] == gen) {
+					if (seenDevice[h] == device) {
+						seen = true;
+						break;
+					}
+					h = (h + 1) & (tableSize - 1);
+				}
+				if (seen) {
+					skipped++;
+					continue;
+				}
+				seenGen[h] = gen;
+				seenDevice[h] = device;
+				if (batch[i].op == CommandOp::TurnOn) device->turnOn();
+				else if (batch[i].op == CommandOp::TurnOff) device->turnOff();
+			}
+			for (Item& done : batch) {
+				if (done.done) {
+					done.done->set_value();
+					delete done.done;
+				}
+			}
+			shard.processed.fetch_add(batch.size(), std::memory_order_relaxed);
+			shard.coalesced.fetch_add(skipped, std::memory_order_relaxed);
+			continue;
+		}
+		if (stop) return;
+
+		shard.doorbell.wait([&] { return shard.queue.empty() && !stopping; });
+	}
+}
+
+#endif
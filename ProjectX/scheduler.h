@@ -0,0 +1,156 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <string>
+#include <map>
+#include <memory>
+#include <chrono>
+#include <ctime>
+#include <thread>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include "device.h"
+#include "threadpool.h"
+#include "timingwheel.h"
+
+class ScheduleStrategy {
+public:
+	virtual void executeSchedule(std::map<std::string, std::shared_ptr<Device>>& devices) = 0;
+	virtual ~ScheduleStrategy() {}
+};
+
+class NightTimeSchedule : public ScheduleStrategy {
+public:
+	void executeSchedule(std::map<std::string, std::shared_ptr<Device>>& devices) override {
+		for (auto it = devices.begin(); it != devices.end(); ++it) {
+			const std::string& name = it->first;
+			std::shared_ptr<Device>& dev = it->second;
+			if (name.find("Light") != std::string::npos) {
+				dev->turnOff();
+			}
+		}
+
+	}
+};
+
+class Scheduler {
+	std::shared_ptr<ScheduleStrategy> strategy;
+public:
+	void setStrategy(std::shared_ptr<ScheduleStrategy> strat) { strategy = strat; }
+	void run(std::map<std::string, std::shared_ptr<Device>>& devices) {
+		if (strategy) strategy->executeSchedule(devices);
+	}
+};
+
+// Runs schedule rules off a timing wheel. Every rule runs on the engine's
+// single worker thread, so rules never overlap each other. The device map is
+// not locked: while an engine is running, other threads must not insert into
+// or erase from it except through post(), which runs on that same thread.
+// Rules that write to devices another thread also drives (a Remote, the
+// main thread) should hand those writes to a CommandPipeline instead.
+class ScheduleEngine {
+	struct DailyRule {
+		std::shared_ptr<ScheduleStrategy> strategy;
+		int hour;
+		int minute;
+		std::chrono::system_clock::time_point due;	// guarded by dailyMutex, like the two below
+		TimingWheel::TimerId timer;
+		bool cancelled = false;
+	};
+
+	// Declared before the pool so a rule still running at shutdown finds them.
+	std::mutex dailyMutex;
+	std::unordered_map<uint64_t, std::shared_ptr<DailyRule>> dailyRules;	// by first timer id
+	ThreadPool pool;
+	TimingWheel wheel;
+	std::map<std::string, std::shared_ptr<Device>>& devices;
+
+	static uint64_t keyOf(TimingWheel::TimerId id) {
+		return (uint64_t(id.index) << 32) | id.generation;
+	}
+
+	// First local hour:minute strictly after 'after'. mktime works out the UTC
+	// offset of that day itself, so a DST change in between is accounted for.
+	static std::chrono::system_clock::time_point nextDaily(int hour, int minute,
+		std::chrono::system_clock::time_point after) {
+		std::time_t timeT = std::chrono::system_clock::to_time_t(after);
+		std::tm today{};
+#ifdef _WIN32
+		localtime_s(&today, &timeT);
+#else
+		localtime_r(&timeT, &today);
+#endif
+		for (int days = 0;; days++) {
+			std::tm at = today;
+			at.tm_mday += days;
+			at.tm_hour = hour;
+			at.tm_min = minute;
+			at.tm_sec = 0;
+			at.tm_isdst = -1;
+			auto next = std::chrono::system_clock::from_time_t(std::mktime(&at));
+			if (next > after) return next;
+		}
+	}
+
+	// Called with dailyMutex held. Each run arms the next one-shot timer from
+	// the wall-clock time it was due, never from a fixed 24h period.
+	void armDaily(std::shared_ptr<DailyRule> rule) {
+		auto delay = std::chrono::duration_cast<std::chrono::milliseconds>(rule->due - std::chrono::system_clock::now());
+		rule->timer = wheel.schedule(std::max(delay, std::chrono::milliseconds(0)), [this, rule] {
+			rule->strategy->executeSchedule(devices);
+			std::lock_guard<std::mutex> lock(dailyMutex);
+			if (rule->cancelled) return;
+			rule->due = nextDaily(rule->hour, rule->minute, rule->due);
+			armDaily(rule);
+		});
+	}
+public:
+	ScheduleEngine(std::map<std::string, std::shared_ptr<Device>>& devs)
+		: pool(1), wheel(pool), devices(devs) {
+		wheel.start();
+	}
+
+	// Runs fn(devices) on the rule thread, e.g. to register a device while rules are live.
+	template<class F>
+	std::future<void> post(F&& fn) {
+		return pool.enqueue([this, fn = std::forward<F>(fn)]() mutable { fn(devices); });
+	}
+
+	TimingWheel::TimerId addRule(std::shared_ptr<ScheduleStrategy> strategy, std::chrono::milliseconds delay,
+		std::chrono::milliseconds period = std::chrono::milliseconds(0)) {
+		return wheel.schedule(delay, [this, strategy] { strategy->executeSchedule(devices); }, period);
+	}
+
+	// Runs every day at hour:minute local time, e.g. addDailyRule(acOff, 23, 0),
+	// also across DST changes. The returned id stays valid for cancelRule()
+	// although each day runs on a fresh timer.
+	TimingWheel::TimerId addDailyRule(std::shared_ptr<ScheduleStrategy> strategy, int hour, int minute) {
+		auto rule = std::make_shared<DailyRule>();
+		rule->strategy = std::move(strategy);
+		rule->hour = hour;
+		rule->minute = minute;
+		rule->due = nextDaily(hour, minute, std::chrono::system_clock::now());
+
+		std::lock_guard<std::mutex> lock(dailyMutex);
+		armDaily(rule);
+		dailyRules.emplace(keyOf(rule->timer), rule);
+		return rule->timer;
+	}
+
+	bool cancelRule(TimingWheel::TimerId id) {
+		{
+			std::lock_guard<std::mutex> lock(dailyMutex);
+			auto it = dailyRules.find(keyOf(id));
+			if (it != dailyRules.end()) {
+				wheel.cancel(it->second->timer);
+				it->second->cancelled = true;
+				dailyRules.erase(it);
+				return true;
+			}
+		}
+		return wheel.cancel(id);
+	}
+};
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <thread>
+#include <condition_variable>
+#include <queue>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <functional>
+#include <future>
+#include <type_traits>
+
+class ThreadPool {
+public:
+	ThreadPool(size_t threads);
+	~ThreadPool();
+
+	template<class F, class... Args>
+	auto enqueue(F&& f, Args&&... args) -> std::future<typename std::invoke_result<F, Args...>::type>;
+
+	template<class F>
+	void post(F&& f);
+
+	size_t size() const { return workers.size(); }
+
+private:
+	std::mutex queueMutex;
+	std::condition_variable condition;
+	std::vector<std::thread> workers;
+	std::queue<std::function<void()>> tasks;
+	std::atomic<bool> stop;
+
+	void worker();
+};
+
+inline ThreadPool::ThreadPool(size_t threads) : stop(false) {
+	for (size_t i = 0; i < threads; i++) {
+		workers.emplace_back(&ThreadPool::worker, this);
+	}
+}
+
+inline ThreadPool::~ThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		stop = true;
+	}
+	condition.notify_all();
+	for (std::thread& work : workers) {
+		if (work.joinable()) {
+			work.join();
+		}
+	}
+}
+
+inline void ThreadPool::worker() {
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			condition.wait(lock, [this] { return stop || !tasks.empty(); });
+
+			if (stop && tasks.empty()) return;
+
+			task = std::move(tasks.front());
+			tasks.pop();
+		}
+		task();
+	}
+}
+
+template<class F, class... Args>
+auto ThreadPool::enqueue(F&& f, Args&&... args) -> std::future<typename std::invoke_result<F, Args...>::type> {
+	using return_type = typename std::invoke_result<F, Args...>::type;
+
+	auto task = std::make_shared<std::packaged_task<return_type()>>(
+		std::bind(std::forward<F>(f), std::forward<Args>(args)...)
+	);
+
+	std::future<return_type> res = task->get_future();
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		tasks.emplace([task]() { (*task)(); });
+	}
+	condition.notify_one();
+	return res;
+}
+
+// Fire-and-forget variant of enqueue: no packaged_task or future allocation.
+template<class F>
+void ThreadPool::post(F&& f) {
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		tasks.emplace(std::forward<F>(f));
+	}
+	condition.notify_one();
+}
+
+#endif
@@ -0,0 +1,389 @@
+#ifndef TIMINGWHEEL_H
+#define TIMINGWHEEL_H
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include "threadpool.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Hierarchical timing wheel (4 levels x 256 slots) with O(1) schedule/cancel.
+// A single timer thread sleeps until the next occupied slot, so thousands of
+// rules due on the same tick cost one wakeup, and an idle wheel costs none.
+class TimingWheel {
+public:
+	using Clock = std::chrono::steady_clock;
+	using Callback = std::function<void()>;
+
+	struct TimerId {
+		uint32_t index = UINT32_MAX;
+		uint32_t generation = 0;
+	};
+
+	TimingWheel(ThreadPool& pool, std::chrono::milliseconds tick = std::chrono::milliseconds(1));
+	~TimingWheel();
+
+	void start();
+	void stop();
+
+	TimerId schedule(std::chrono::milliseconds delay, Callback cb,
+		std::chrono::milliseconds period = std::chrono::milliseconds(0));
+	TimerId scheduleAt(Clock::time_point when, Callback cb,
+		std::chrono::milliseconds period = std::chrono::milliseconds(0));
+	bool cancel(TimerId id);
+
+	// Moves the wheel forward to 'now' and hands every due callback to the pool.
+	// The timer thread calls this; benchmarks may drive it directly instead.
+	size_t advance(Clock::time_point now);
+
+	void reserve(size_t timers);
+	size_t pending() const;
+
+private:
+	static constexpr int LevelBits = 8;
+	static constexpr int Levels = 4;
+	static constexpr uint32_t Slots = 1u << LevelBits;
+	static constexpr uint64_t SlotMask = Slots - 1;
+	static constexpr uint32_t Nil = UINT32_MAX;
+	static constexpr uint64_t Never = UINT64_MAX;
+
+	struct Node {
+		uint64_t expiry = 0;
+		uint64_t period = 0;
+		uint32_t prev = Nil;
+		uint32_t next = Nil;
+		uint32_t generation = 0;
+		uint8_t level = 0;
+		uint8_t slot = 0;
+		bool active = false;
+		Callback cb;
+	};
+
+	ThreadPool& pool;
+	const Clock::duration tick;
+	const Clock::time_point epoch;
+
+	mutable std::mutex mutex;
+	std::condition_variable wakeup;
+	std::thread timerThread;
+	bool running = false;
+	uint64_t plannedWake = Never;
+
+	std::vector<Node> nodes;
+	uint32_t freeHead = Nil;
+	size_t active = 0;
+	uint64_t currentTick = 0;
+	uint32_t heads[Levels][Slots];
+	uint64_t occupied[Levels][Slots / 64];
+
+	uint64_t tickOf(Clock::time_point tp) const;
+	Clock::time_point timeOf(uint64_t t) const { return epoch + tick * t; }
+
+	uint32_t allocNode();
+	void freeNode(uint32_t index);
+	void link(uint32_t index);
+	void unlink(uint32_t index);
+	void cascade(int level, uint32_t slot);
+	uint64_t nextEventTick() const;
+	void collect(uint64_t target, std::vector<Callback>& due);
+	void dispatch(std::vector<Callback>& due);
+	void run();
+
+	static int findNext(const uint64_t* bits, uint32_t from);
+};
+
+inline TimingWheel::TimingWheel(ThreadPool& p, std::chrono::milliseconds t)
+	: pool(p), tick(std::chrono::duration_cast<Clock::duration>(t)), epoch(Clock::now()) {
+	for (int l = 0; l < Levels; l++) {
+		std::fill(std::begin(heads[l]), std::end(heads[l]), Nil);
+		std::fill(std::begin(occupied[l]), std::end(occupied[l]), 0);
+	}
+}
+
+inline TimingWheel::~TimingWheel() {
+	stop();
+}
+
+inline void TimingWheel::start() {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (running) return;
+	running = true;
+	timerThread = std::thread(&TimingWheel::run, this);
+}
+
+inline void TimingWheel::stop() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		running = false;
+	}
+	wakeup.notify_one();
+	if (timerThread.joinable()) {
+		timerThread.join();
+	}
+}
+
+inline TimingWheel::TimerId TimingWheel::schedule(std::chrono::milliseconds delay, Callback cb,
+	std::chrono::milliseconds period) {
+	return scheduleAt(Clock::now() + delay, std::move(cb), period);
+}
+
+inline TimingWheel::TimerId TimingWheel::scheduleAt(Clock::time_point when, Callback cb,
+	std::chrono::milliseconds period) {
+	uint64_t periodTicks = 0;
+	if (period.count() > 0) {
+		periodTicks = std::max<uint64_t>(1, (std::chrono::duration_cast<Clock::duration>(period) + tick - Clock::duration(1)) / tick);
+	}
+
+	bool earlier;
+	TimerId id;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		uint32_t index = allocNode();
+		Node& node = nodes[index];
+		// Round up so a timer never fires early, and never insert into the slot
+		// being expired; overdue timers fire on the next tick.
+		uint64_t expiry = tickOf(when);
+		if (timeOf(expiry) < when) expiry++;
+		node.expiry = std::max(expiry, currentTick + 1);
+		node.period = periodTicks;
+		node.cb = std::move(cb);
+		link(index);
+		active++;
+
+		id.index = index;
+		id.generation = node.generation;
+		earlier = node.expiry < plannedWake;
+	}
+	if (earlier) wakeup.notify_one();
+	return id;
+}
+
+inline bool TimingWheel::cancel(TimerId id) {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (id.index >= nodes.size()) return false;
+	Node& node = nodes[id.index];
+	if (!node.active || node.generation != id.generation) return false;
+	unlink(id.index);
+	freeNode(id.index);
+	active--;
+	return true;
+}
+
+inline size_t TimingWheel::advance(Clock::time_point now) {
+	std::vector<Callback> due;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		collect(tickOf(now), due);
+	}
+	size_t fired = due.size();
+	dispatch(due);
+	return fired;
+}
+
+inline void TimingWheel::reserve(size_t timers) {
+	std::lock_guard<std::mutex> lock(mutex);
+	nodes.reserve(timers);
+}
+
+inline size_t TimingWheel::pending() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return active;
+}
+
+inline uint64_t TimingWheel::tickOf(Clock::time_point tp) const {
+	if (tp <= epoch) return 0;
+	return static_cast<uint64_t>((tp - epoch) / tick);
+}
+
+inline uint32_t TimingWheel::allocNode() {
+	if (freeHead != Nil) {
+		uint32_t index = freeHead;
+		freeHead = nodes[index].next;
+		return index;
+	}
+	nodes.emplace_back();
+	return static_cast<uint32_t>(nodes.size() - 1);
+}
+
+inline void TimingWheel::freeNode(uint32_t index) {
+	Node& node = nodes[index];
+	node.cb = nullptr;
+	node.active = false;
+	node.generation++;
+	node.prev = Nil;
+	node.next = freeHead;
+	freeHead = index;
+}
+
+inline void TimingWheel::link(uint32_t index) {
+	Node& node = nodes[index];
+	uint64_t delta = node.expiry - currentTick;
+	int level = 0;
+	while (level < Levels - 1 && delta >= (uint64_t(1) << (LevelBits * (level + 1)))) {
+		level++;
+	}
+	// Anything beyond the top level's range parks in the furthest top slot and
+	// is re-linked with its real expiry when that slot cascades.
+	uint64_t slotTick = std::min<uint64_t>(node.expiry, currentTick + 0xFFFFFFFFull);
+	uint32_t slot = static_cast<uint32_t>((slotTick >> (LevelBits * level)) & SlotMask);
+
+	node.level = static_cast<uint8_t>(level);
+	node.slot = static_cast<uint8_t>(slot);
+	node.active = true;
+	node.prev = Nil;
+	node.next = heads[level][slot];
+	if (node.next != Nil) nodes[node.next].prev = index;
+	heads[level][slot] = index;
+	occupied[level][slot / 64] |= uint64_t(1) << (slot % 64);
+}
+
+inline void TimingWheel::unlink(uint32_t index) {
+	Node& node = nodes[index];
+	if (node.prev != Nil) nodes[node.prev].next = node.next;
+	else heads[node.level][node.slot] = node.next;
+	if (node.next != Nil) nodes[node.next].prev = node.prev;
+	if (heads[node.level][node.slot] == Nil) {
+		occupied[node.level][node.slot / 64] &= ~(uint64_t(1) << (node.slot % 64));
+	}
+	node.prev = node.next = Nil;
+}
+
+inline void TimingWheel::cascade(int level, uint32_t slot) {
+	uint32_t index = heads[level][slot];
+	heads[level][slot] = Nil;
+	occupied[level][slot / 64] &= ~(uint64_t(1) << (slot % 64));
+	while (index != Nil) {
+		uint32_t next = nodes[index].next;
+		link(index);
+		index = next;
+	}
+}
+
+inline int TimingWheel::findNext(const uint64_t* bits, uint32_t from) {
+	const uint32_t words = Slots / 64;
+	uint32_t word = from / 64;
+	uint64_t w = bits[word] & (~uint64_t(0) << (from % 64));
+	for (uint32_t n = 1; ; n++) {
+		if (w) {
+#ifdef _MSC_VER
+			unsigned long bit;
+			_BitScanForward64(&bit, w);
+#else
+			unsigned bit = static_cast<unsigned>(__builtin_ctzll(w));
+#endif
+			return static_cast<int>(word * 64 + bit);
+		}
+		if (n > words) return -1;
+		word = (word + 1) % words;
+		w = bits[word];
+		if (n == words) {
+			// Wrapped back to the first word: only the bits before 'from' remain.
+			w &= (from % 64) ? ((uint64_t(1) << (from % 64)) - 1) : 0;
+		}
+	}
+}
+
+inline uint64_t TimingWheel::nextEventTick() const {
+	uint64_t next = Never;
+	for (int level = 0; level < Levels; level++) {
+		uint32_t shift = LevelBits * level;
+		uint64_t cursor = currentTick >> shift;
+		int slot = findNext(occupied[level], static_cast<uint32_t>((cursor + 1) & SlotMask));
+		if (slot < 0) continue;
+		uint64_t distance = (static_cast<uint64_t>(slot) - cursor) & SlotMask;
+		if (distance == 0) distance = Slots;
+		next = std::min(next, (cursor + distance) << shift);
+	}
+	return next;
+}
+
+inline void TimingWheel::collect(uint64_t target, std::vector<Callback>& due) {
+	while (true) {
+		uint64_t next = nextEventTick();
+		if (next > target) {
+			currentTick = std::max(currentTick, target);
+			break;
+		}
+		currentTick = next;
+
+		for (int level = Levels - 1; level > 0; level--) {
+			uint32_t shift = LevelBits * level;
+			if ((currentTick & ((uint64_t(1) << shift) - 1)) == 0) {
+				cascade(level, static_cast<uint32_t>((currentTick >> shift) & SlotMask));
+			}
+		}
+
+		uint32_t slot = static_cast<uint32_t>(currentTick & SlotMask);
+		uint32_t index = heads[0][slot];
+		heads[0][slot] = Nil;
+		occupied[0][slot / 64] &= ~(uint64_t(1) << (slot % 64));
+		while (index != Nil) {
+			Node& node = nodes[index];
+			uint32_t next = node.next;
+			if (node.period) {
+				due.push_back(node.cb);
+				node.expiry += node.period;
+				if (node.expiry <= currentTick) {
+					node.expiry += ((currentTick - node.expiry) / node.period + 1) * node.period;
+				}
+				link(index);
+			}
+			else {
+				due.push_back(std::move(node.cb));
+				freeNode(index);
+				active--;
+			}
+			index = next;
+		}
+	}
+}
+
+inline void TimingWheel::dispatch(std::vector<Callback>& due) {
+	if (due.empty()) return;
+	// One pool task per worker rather than per rule keeps queue traffic flat
+	// when a whole building's rules land on the same tick.
+	size_t chunks = std::min(due.size(), std::max<size_t>(1, pool.size()));
+	size_t per = (due.size() + chunks - 1) / chunks;
+	for (size_t begin = 0; begin < due.size(); begin += per) {
+		size_t end = std::min(due.size(), begin + per);
+		auto batch = std::make_shared<std::vector<Callback>>(
+			std::make_move_iterator(due.begin() + begin), std::make_move_iterator(due.begin() + end));
+		pool.post([batch] {
+			for (Callback& cb : *batch) cb();
+		});
+	}
+	due.clear();
+}
+
+inline void TimingWheel::run() {
+	std::vector<Callback> due;
+	std::unique_lock<std::mutex> lock(mutex);
+	while (running) {
+		collect(tickOf(Clock::now()), due);
+		if (!due.empty()) {
+			lock.unlock();
+			dispatch(due);
+			lock.lock();
+			continue;
+		}
+
+		plannedWake = nextEventTick();
+		if (plannedWake == Never) {
+			wakeup.wait(lock);
+		}
+		else {
+			wakeup.wait_until(lock, timeOf(plannedWake));
+		}
+		plannedWake = Never;
+	}
+}
+
+#endif
@@ -6,6 +6,8 @@
 #include <mutex>
 #include <condition_variable>
 #include <functional>
+#include <atomic>
+#include <cstdint>
 #include <fstream>
 #include <sstream>
 #include <memory>
@@ -31,7 +33,7 @@ private:
 	void worker();
 };
 
-ThreadPool::ThreadPool(size_t numThreads) {
+ThreadPool::ThreadPool(size_t numThreads) : stop(false) {
 	for (size_t i = 0; i < numThreads; i++) {
 		workers.emplace_back([this] {this->worker(); });
 	}
@@ -0,0 +1,244 @@
+#ifndef LOGCODEC_H
+#define LOGCODEC_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+
+// Compressed log segment (.lgz):
+//   LogFileHeader
+//   blocks, each an independently compressed run of whole lines
+//   LogBlockIndex[blockCount] at indexOffset
+// Block timestamps are packed as YYYYMMDDhhmmss so they compare as numbers.
+struct LogFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t blockCount;
+    uint64_t indexOffset;
+};
+
+struct LogBlockIndex {
+    uint64_t offset;
+    uint32_t compressedSize;
+    uint32_t rawSize;
+    uint64_t minTime;    // 0 when no line in the block carries a timestamp
+    uint64_t maxTime;
+};
+
+// LZ77 block codec in the LZ4 style: a token byte holds the literal length
+// and match length nibbles (15 means more length bytes follow), then the
+// literals, then a 2-byte little-endian offset. The last sequence of a block
+// has literals only.
+class LogCodec {
+public:
+    static constexpr uint32_t Magic = 0x315A474C;    // "LGZ1"
+    static constexpr size_t DefaultBlockSize = 64 * 1024;
+
+    static void compressBlock(const char* src, size_t size, std::string& out);
+    static bool decompressBlock(const char* src, size_t size, size_t rawSize, std::string& out);
+
+    // Packs the "[YYYY-MM-DD hh:mm:ss]" prefix Logger writes; 0 if absent.
+    static uint64_t parseTimestamp(const char* line, size_t size);
+
+    static bool compressFile(const std::string& inPath, const std::string& outPath,
+        size_t blockSize = DefaultBlockSize);
+    static bool readIndex(std::ifstream& in, LogFileHeader& header, std::vector<LogBlockIndex>& index);
+
+private:
+    static constexpr int HashBits = 14;
+    static constexpr size_t MinMatch = 4;
+    static constexpr size_t MaxOffset = 65535;
+
+    static uint32_t read32(const char* p) {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    static uint32_t hash(uint32_t v) {
+        return (v * 2654435761u) >> (32 - HashBits);
+    }
+
+    static void writeLength(size_t length, std::string& out) {
+        while (length >= 255) {
+            out.push_back(static_cast<char>(255));
+            length -= 255;
+        }
+        out.push_back(static_cast<char>(length));
+    }
+
+    static void emit(const char* literals, size_t literalCount, size_t offset, size_t matchLength, std::string& out) {
+        size_t matchCode = matchLength ? matchLength - MinMatch : 0;
+        out.push_back(static_cast<char>(((literalCount < 15 ? literalCount : 15) << 4) | (matchCode < 15 ? matchCode : 15)));
+        if (literalCount >= 15) writeLength(literalCount - 15, out);
+        out.append(literals, literalCount);
+        if (!matchLength) return;
+        out.push_back(static_cast<char>(offset & 0xFF));
+        out.push_back(static_cast<char>(offset >> 8));
+        if (matchCode >= 15) writeLength(matchCode - 15, out);
+    }
+
+    static bool readLength(const unsigned char*& p, const unsigned char* end, size_t& length) {
+        unsigned char b;
+        do {
+            if (p == end) return false;
+            b = *p++;
+            length += b;
+        } while (b == 255);
+        return true;
+    }
+};
+
+inline void LogCodec::compressBlock(const char* src, size_t size, std::string& out) {
+    // Positions are stored +1 so that 0 means "empty slot".
+    std::vector<uint32_t> table(size_t(1) << HashBits, 0);
+    size_t anchor = 0;
+    size_t pos = 0;
+    while (pos + MinMatch <= size) {
+        uint32_t sequence = read32(src + pos);
+        uint32_t& slot = table[hash(sequence)];
+        size_t candidate = slot;
+        slot = static_cast<uint32_t>(pos + 1);
+        if (candidate && pos - (candidate - 1) <= MaxOffset && read32(src + candidate - 1) == sequence) {
+            size_t match = candidate - 1;
+            size_t length = MinMatch;
+            while (pos + length < size && src[match + length] == src[pos + length]) length++;
+            emit(src + anchor, pos - anchor, pos - match, length, out);
+            pos += length;
+            anchor = pos;
+        }
+        else {
+            pos++;
+        }
+    }
+    emit(src + anchor, size - anchor, 0, 0, out);
+}
+
+inline bool LogCodec::decompressBlock(const char* src, size_t size, size_t rawSize, std::string& out) {
+    size_t start = out.size();
+    out.resize(start + rawSize);
+    char* dst = &out[start];
+    size_t written = 0;
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(src);
+    const unsigned char* end = p + size;
+
+    while (p < end) {
+        unsigned char token = *p++;
+        size_t literals = token >> 4;
+        if (literals == 15 && !readLength(p, end, literals)) return false;
+        if (literals > static_cast<size_t>(end - p) || literals > rawSize - written) return false;
+        std::memcpy(dst + written, p, literals);
+        p += literals;
+        written += literals;
+        if (p == end) break;
+
+        if (end - p < 2) return false;
+        size_t offset = p[0] | (static_cast<size_t>(p[1]) << 8);
+        p += 2;
+        size_t length = token & 15;
+        if (length == 15 && !readLength(p, end, length)) return false;
+        length += MinMatch;
+        if (offset == 0 || offset > written || length > rawSize - written) return false;
+        // Byte by byte: the match may overlap the bytes it produces.
+        for (size_t i = 0; i < length; i++) {
+            dst[written + i] = dst[written - offset + i];
+        }
+        written += length;
+    }
+    return written == rawSize;
+}
+
+inline uint64_t LogCodec::parseTimestamp(const char* line, size_t size) {
+    static const char pattern[] = "[dddd-dd-dd dd:dd:dd]";
+    const size_t length = sizeof(pattern) - 1;
+    if (size < length) return 0;
+    uint64_t packed = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (pattern[i] == 'd') {
+            if (line[i] < '0' || line[i] > '9') return 0;
+            packed = packed * 10 + (line[i] - '0');
+        }
+        else if (line[i] != pattern[i]) {
+            return 0;
+        }
+    }
+    return packed;
+}
+
+// Compresses inPath into outPath in blocks of about blockSize bytes, cut at
+// line ends. Writes to a temporary file first so a crash never leaves a
+// half-written segment under the final name.
+inline bool LogCodec::compressFile(const std::string& inPath, const std::string& outPath, size_t blockSize) {
+    std::ifstream in(inPath, std::ios::binary | std::ios::ate);
+    if (!in.is_open()) return false;
+    std::string raw(static_cast<size_t>(in.tellg()), '\0');
+    in.seekg(0);
+    in.read(&raw[0], raw.size());
+    if (!in) return false;
+
+    std::string tmpPath = outPath + ".tmp";
+    std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) return false;
+
+    LogFileHeader header = { Magic, 1, 0, 0 };
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    std::vector<LogBlockIndex> index;
+    std::string compressed;
+    uint64_t offset = sizeof(header);
+    size_t begin = 0;
+    while (begin < raw.size()) {
+        size_t end = begin + blockSize < raw.size() ? begin + blockSize : raw.size();
+        if (end < raw.size()) {
+            size_t newline = raw.find('\n', end);
+            end = newline == std::string::npos ? raw.size() : newline + 1;
+        }
+
+        LogBlockIndex block = { offset, 0, static_cast<uint32_t>(end - begin), 0, 0 };
+        for (size_t line = begin; line < end;) {
+            size_t next = raw.find('\n', line);
+            next = next == std::string::npos || next >= end ? end : next + 1;
+            uint64_t time = parseTimestamp(raw.data() + line, next - line);
+            if (time) {
+                if (!block.minTime || time < block.minTime) block.minTime = time;
+                if (time > block.maxTime) block.maxTime = time;
+            }
+            line = next;
+        }
+
+        compressed.clear();
+        compressBlock(raw.data() + begin, end - begin, compressed);
+        block.compressedSize = static_cast<uint32_t>(compressed.size());
+        out.write(compressed.data(), compressed.size());
+        offset += compressed.size();
+        index.push_back(block);
+        begin = end;
+    }
+
+    header.blockCount = index.size();
+    header.indexOffset = offset;
+    out.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(LogBlockIndex));
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.close();
+    if (!out) {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    std::remove(outPath.c_str());
+    return std::rename(tmpPath.c_str(), outPath.c_str()) == 0;
+}
+
+inline bool LogCodec::readIndex(std::ifstream& in, LogFileHeader& header, std::vector<LogBlockIndex>& index) {
+    in.seekg(0);
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    if (header.magic != Magic || header.version != 1) return false;
+    index.resize(static_cast<size_t>(header.blockCount));
+    in.seekg(static_cast<std::streamoff>(header.indexOffset));
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(index.data()), index.size() * sizeof(LogBlockIndex)));
+}
+
+#endif